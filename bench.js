@@ -0,0 +1,174 @@
+const fs = require('fs');
+const path = require('path');
+
+const encoder = new TextEncoder("utf-8");
+const decoder = new TextDecoder("utf-8");
+
+// build variants to compare, skipping those that have not been built (see `make bench` and `make addon`)
+const variants = [
+  ["emscripten SjLj", "dist/yaml_to_json_array.js"],
+  ["Wasm SjLj", "dist/yaml_to_json_array_wasm_sjlj.js"],
+  ["native addon", "dist/yaml_to_json.node"]
+].filter(([, file]) => fs.existsSync(path.join(__dirname, file)))
+  .map(([name, file]) => [name, require(path.join(__dirname, file))]);
+
+/**
+ * Measures the throughput of converting a list of YAML documents.
+ *
+ * @param {string} name Name of the benchmark.
+ * @param {string[]} documents YAML documents to convert.
+ * @param {number} rounds Number of times to convert each document.
+ * @param {function} select Picks the conversion function from a build variant (variants without it are skipped).
+ */
+function measure(name, documents, rounds = 10, select = variant => variant.yaml_to_json_array) {
+  const arrays = documents.map(d => encoder.encode(d));
+  const bytes = arrays.reduce((total, a) => total + a.length, 0) * rounds;
+
+  for (const [variant, module] of variants) {
+    const convert = select(module);
+    if (!convert) {
+      continue;
+    }
+
+    // warm up
+    for (const a of arrays) {
+      convert(a);
+    }
+
+    const start = process.hrtime.bigint();
+    for (let k = 0; k < rounds; ++k) {
+      for (const a of arrays) {
+        convert(a);
+      }
+    }
+    const elapsed = Number(process.hrtime.bigint() - start) / 1e9;
+    console.log(`${name} [${variant}]: ${(1000 * elapsed).toFixed(1)} ms, ${(bytes / elapsed / (1 << 20)).toFixed(1)} MB/s`);
+  }
+}
+
+// long block scalars with characters that must be escaped in JSON strings
+function block_scalar_document(keys, lines) {
+  let yaml = "";
+  for (let i = 0; i < keys; ++i) {
+    yaml += `key${i}: |\n`;
+    for (let j = 0; j < lines; ++j) {
+      yaml += `  Line ${j} of a long block scalar with "quotes", back\\slashes and\ttabs in running text.\n`;
+    }
+  }
+  return yaml;
+}
+measure("block scalars", Array.from({ length: 100 }, () => block_scalar_document(10, 50)));
+
+// metrics dumps where most scalars are numbers
+function metrics_document(samples) {
+  let yaml = "samples:\n";
+  for (let i = 0; i < samples; ++i) {
+    yaml += `- {ts: ${1700000000 + i}, cpu: ${(i % 100) / 7}, mem: ${i * 1024}, load: -${i % 13}.25e-2, ok: ${i % 2 == 0}, tag: m${i}}\n`;
+  }
+  return yaml;
+}
+measure("numeric scalars", Array.from({ length: 100 }, () => metrics_document(500)));
+
+// rows that are already JSON
+function json_document(items) {
+  return JSON.stringify({ items: Array.from({ length: items }, (_, i) => ({ id: i, name: `item ${i}`, price: i * 1.5, tags: ["a", "b"], active: i % 3 == 0 })) }, null, 2);
+}
+measure("JSON input", Array.from({ length: 100 }, () => json_document(200)));
+
+// many small rows, a share of which are malformed and take the error path
+function small_document(i) {
+  return `id: ${i}\nname: row ${i}\nvalues: [${i}, ${i + 1}, ${i + 2}]\nnested: {a: b, c: d}\n`;
+}
+for (const invalid of [0, 0.1, 0.5]) {
+  const rows = Array.from({ length: 10000 }, (_, i) => i % 100 < 100 * invalid ? `{${small_document(i)}` : small_document(i));
+  measure(`small rows with ${100 * invalid}% invalid`, rows);
+}
+
+// documents from 1 KB to 64 MB, which exercise heap growth
+function sized_document(size) {
+  const item = "- {id: 12345, name: an item in a long list, tags: [alpha, beta], price: 12.5}\n";
+  return item.repeat(Math.max(1, Math.round(size / item.length)));
+}
+for (let size = 1 << 10; size <= 64 << 20; size *= 4) {
+  const label = size < (1 << 20) ? `${size >> 10} KB` : `${size >> 20} MB`;
+  measure(`document of ${label}`, [sized_document(size)], Math.max(1, Math.round((16 << 20) / size)));
+}
+
+// nested documents, which stress walking the tree
+function nested_document(depth) {
+  return Array.from({ length: 100 }, (_, i) => "- ".repeat(depth) + `{id: ${i}, name: item}\n`).join("");
+}
+for (const depth of [4, 16, 60]) {
+  measure(`nesting depth of ${depth}`, Array.from({ length: 100 }, () => nested_document(depth)));
+}
+
+// JavaScript values built from a tape, compared to parsing the JSON text output
+const value_documents = Array.from({ length: 100 }, () => metrics_document(500));
+measure("values via JSON.parse", value_documents, 10, variant => a => JSON.parse(decoder.decode(variant.yaml_to_json_array(a))));
+measure("values via tape", value_documents, 10, variant => variant.yaml_to_object);
+
+// selective predicates, which stop parsing at the key rather than converting the entire document
+const service_documents = Array.from({ length: 1000 }, (_, i) => `env: ${i % 10 == 0 ? "prod" : "dev"}\n` + metrics_document(50));
+measure("filter via JSON.parse", service_documents, 10, variant => a => JSON.parse(decoder.decode(variant.yaml_to_json_array(a))).env === "prod");
+measure("filter via yaml_contains", service_documents, 10, variant => variant.yaml_contains && (a => variant.yaml_contains(a, "env", "prod")));
+
+// many fields extracted from each document, looked up path by path or resolved in a single walk
+const field_paths = Array.from({ length: 25 }, (_, i) => `fields.f${2 * i}`);
+const field_documents = Array.from({ length: 1000 }, (_, i) => "fields:\n" + Array.from({ length: 50 }, (_, k) => `  f${k}: value ${i} ${k}\n`).join(""));
+measure("fields via yaml_open", field_documents, 10, variant => variant.yaml_open && (a => {
+  const document = variant.yaml_open(a);
+  const values = field_paths.map(path => document.get(path));
+  document.close();
+  return values;
+}));
+measure("fields via yaml_to_columns", field_documents, 10, variant => variant.yaml_to_columns && (a => variant.yaml_to_columns([a], field_paths)));
+
+// batches converted in parallel, on the threads of the libuv thread pool with the native addon (set its size with
+// `UV_THREADPOOL_SIZE`), and on worker threads that share compiled Wasm code
+const batch = Array.from({ length: 1000 }, (_, i) => encoder.encode(sized_document(4096 + 64 * (i % 64))));
+const batch_bytes = batch.reduce((total, a) => total + a.length, 0);
+async function measure_batch(name, convert) {
+  // warm up
+  await convert(batch);
+
+  const start = process.hrtime.bigint();
+  await convert(batch);
+  const elapsed = Number(process.hrtime.bigint() - start) / 1e9;
+  console.log(`batch [${name}]: ${(1000 * elapsed).toFixed(1)} ms, ${(batch_bytes / elapsed / (1 << 20)).toFixed(1)} MB/s`);
+}
+(async () => {
+  const addon = variants.find(([name]) => name === "native addon");
+  if (addon) {
+    await measure_batch(`native addon, ${process.env.UV_THREADPOOL_SIZE || 4} threads`, rows => addon[1].yamlToJsonBatch(rows));
+  }
+  if (fs.existsSync(path.join(__dirname, "dist/yaml_to_json_array.js"))) {
+    const { YamlPool } = require("./src/pool.js");
+    for (let workers = 1; workers <= require("os").cpus().length; ++workers) {
+      const pool = new YamlPool(workers);
+      await measure_batch(`Wasm pool, ${workers} workers`, rows => pool.convert(rows));
+      await pool.close();
+    }
+  }
+
+  // documents of 128 MB converted by the command-line converter on a single thread and on all cores: a top-level
+  // sequence is split into chunks before parsing, and a map of sequences is parsed serially but written in parallel
+  const cli = path.join(__dirname, "dist/yaml_to_json");
+  if (fs.existsSync(cli)) {
+    const os = require("os");
+    const { spawnSync } = require("child_process");
+    const size = 128 << 20;
+    const large_documents = [
+      ["top-level sequence", sized_document(size)],
+      ["map of sequences", Array.from({ length: 8 }, (_, k) => `group${k}:\n` + sized_document(size / 8).replace(/^(?=.)/gm, "  ")).join("")]
+    ];
+    const file = path.join(os.tmpdir(), "yaml_to_json_bench.yaml");
+    for (const [name, document] of large_documents) {
+      fs.writeFileSync(file, document);
+      for (const threads of new Set([1, os.cpus().length])) {
+        const result = spawnSync(cli, ["-j", String(threads), "-o", os.devNull, file], { encoding: "utf8" });
+        console.log(`${name} of ${size >> 20} MB [command-line converter, ${threads} threads]: ${result.stderr.trim()}`);
+      }
+    }
+    fs.unlinkSync(file);
+  }
+})();
@@ -0,0 +1,114 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#include "cache.hpp"
+#include <cstring>
+
+static inline std::uint64_t load_64(const char* p)
+{
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline std::uint64_t mix_64(std::uint64_t a, std::uint64_t b)
+{
+    // 64x64 -> 128-bit multiply folded into 64 bits (as in wyhash)
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    return static_cast<std::uint64_t>(r) ^ static_cast<std::uint64_t>(r >> 64);
+}
+
+std::uint64_t hash_bytes(const char* data, std::size_t size)
+{
+    constexpr std::uint64_t p0 = UINT64_C(0xa0761d6478bd642f);
+    constexpr std::uint64_t p1 = UINT64_C(0xe7037ed1a0b428db);
+    constexpr std::uint64_t p2 = UINT64_C(0x8ebc6af09c88c6e3);
+
+    std::uint64_t h = p0 ^ size;
+    const char* p = data;
+    std::size_t n = size;
+    while (n >= 16) {
+        h = mix_64(load_64(p) ^ p1, load_64(p + 8) ^ h);
+        p += 16;
+        n -= 16;
+    }
+    if (n >= 8) {
+        h = mix_64(load_64(p) ^ p1, h ^ p2);
+        p += 8;
+        n -= 8;
+    }
+    if (n > 0) {
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, p, n);
+        h = mix_64(tail ^ p1, h ^ p2);
+    }
+    return mix_64(h ^ p0, size ^ p1);
+}
+
+void ResultCache::set_capacity(std::size_t capacity)
+{
+    _capacity = capacity;
+    shrink_to(capacity);
+}
+
+bool ResultCache::find(const char* key, std::size_t key_len, std::uint64_t hash, String*& result)
+{
+    auto it = _index.find(hash);
+    if (it == _index.end() || it->second->key.size() != key_len || std::memcmp(it->second->key.data(), key, key_len) != 0) {
+        ++_misses;
+        return false;
+    }
+
+    // move entry to the front of the recently used list
+    _entries.splice(_entries.begin(), _entries, it->second);
+
+    const Entry& entry = _entries.front();
+    result = entry.has_value ? new String(entry.value.data(), entry.value.size()) : nullptr;
+    ++_hits;
+    return true;
+}
+
+void ResultCache::insert(std::uint64_t hash, std::string&& key, const String* result)
+{
+    Entry entry{ hash, std::move(key), result ? std::string(result->data(), result->size()) : std::string(), result != nullptr };
+    std::size_t footprint = entry.footprint();
+    if (footprint > _capacity) {
+        return;
+    }
+
+    // replace an entry whose key has the same hash (i.e. a hash collision)
+    auto it = _index.find(hash);
+    if (it != _index.end()) {
+        _bytes -= it->second->footprint();
+        _entries.erase(it->second);
+        _index.erase(it);
+    }
+
+    shrink_to(_capacity - footprint);
+    _entries.push_front(std::move(entry));
+    _index.emplace(hash, _entries.begin());
+    _bytes += footprint;
+}
+
+void ResultCache::clear()
+{
+    _entries.clear();
+    _index.clear();
+    _bytes = 0;
+}
+
+void ResultCache::shrink_to(std::size_t capacity)
+{
+    while (_bytes > capacity && !_entries.empty()) {
+        const Entry& entry = _entries.back();
+        _bytes -= entry.footprint();
+        _index.erase(entry.hash);
+        _entries.pop_back();
+        ++_evictions;
+    }
+}
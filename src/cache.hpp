@@ -0,0 +1,87 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#pragma once
+#include "string.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+/** Computes a fast non-cryptographic 64-bit hash of a byte sequence. */
+std::uint64_t hash_bytes(const char* data, std::size_t size);
+
+/**
+ * A bounded least-recently-used cache of conversion results keyed by input content.
+ *
+ * Entries are located by a 64-bit hash of the input, and confirmed with a full byte-wise comparison.
+ * A cached result may be empty, which stands for a conversion that has failed.
+ */
+class ResultCache
+{
+public:
+    /** Sets the maximum number of bytes held by the cache, evicting entries as necessary. Zero disables the cache. */
+    void set_capacity(std::size_t capacity);
+
+    /** True if results are to be looked up in and stored into the cache. */
+    bool enabled() const
+    {
+        return _capacity > 0;
+    }
+
+    /**
+     * Looks up the result of a previous conversion.
+     *
+     * @param key The input string.
+     * @param hash The hash of the input string.
+     * @param result A (newly allocated) copy of the cached result, or null if the conversion has failed.
+     * @returns True if the input has been found in the cache.
+     */
+    bool find(const char* key, std::size_t key_len, std::uint64_t hash, String*& result);
+
+    /** Stores the result of a conversion, with null standing for a failed conversion. */
+    void insert(std::uint64_t hash, std::string&& key, const String* result);
+
+    /** Removes all entries from the cache. */
+    void clear();
+
+    std::size_t hits() const { return _hits; }
+    std::size_t misses() const { return _misses; }
+    std::size_t evictions() const { return _evictions; }
+    std::size_t entries() const { return _entries.size(); }
+    std::size_t bytes() const { return _bytes; }
+
+private:
+    struct Entry
+    {
+        std::uint64_t hash;
+        std::string key;
+        std::string value;
+        bool has_value;
+
+        /** Approximate number of bytes consumed by the entry including bookkeeping. */
+        std::size_t footprint() const
+        {
+            return sizeof(Entry) + 4 * sizeof(void*) + key.size() + value.size();
+        }
+    };
+
+    /** Discards least recently used entries until the cache fits in the given number of bytes. */
+    void shrink_to(std::size_t capacity);
+
+private:
+    /** Entries ordered from most recently to least recently used. */
+    std::list<Entry> _entries;
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> _index;
+    std::size_t _capacity = 0;
+    std::size_t _bytes = 0;
+    std::size_t _hits = 0;
+    std::size_t _misses = 0;
+    std::size_t _evictions = 0;
+};
@@ -6,42 +6,36 @@
  * @see https://github.com/hunyadi/yaml-to-json
 **/
 
-#include "ryml_all.hpp"
 #include "string.hpp"
 #include "utf8.hpp"
-#include <csetjmp>
+#include "yaml.hpp"
 
-static std::jmp_buf parse_error_handler;
-static std::string error_message;
+static yaml::Options options;
 
-static void* parser_allocate(size_t len, void* hint, void* user_data)
+/** Identifies a limit that documents must observe (same identifiers as in `transform_configure`). */
+enum Option
 {
-    return std::malloc(len);
-}
-
-static void parser_free(void* mem, size_t size, void* user_data)
-{
-    std::free(mem);
-}
-
-static void parser_raise(const char* msg, size_t len, ryml::Location location, void* user_data)
-{
-    constexpr const char* fmt = "%s in YAML at line %zu column %zu offset %zu";
-    int count = std::snprintf(nullptr, 0, fmt, msg, location.line, location.col, location.offset);
-    if (count >= 0) {
-        error_message.resize(count + 1);
-        std::snprintf(error_message.data(), error_message.size(), fmt, msg, location.line, location.col, location.offset);
-    } else {
-        error_message.clear();
-    }
-
-    longjmp(parse_error_handler, 1);
-}
+    /** Maximum nesting depth of documents. */
+    OPTION_MAX_DEPTH = 2,
+    /** Maximum length of YAML input in bytes (zero for no limit). */
+    OPTION_MAX_INPUT_BYTES = 3,
+    /** Maximum number of nodes in a YAML document (zero for no limit). */
+    OPTION_MAX_NODES = 4,
+    /** Maximum length of JSON output in bytes (zero for no limit). */
+    OPTION_MAX_OUTPUT_BYTES = 5,
+    /** Whether to replace aliases and merge keys with what they refer to (non-zero) or write aliases as strings (zero). */
+    OPTION_EXPAND_ALIASES = 6,
+    /** Maximum number of bytes written on behalf of aliases and merge keys (zero for no limit). */
+    OPTION_MAX_EXPANSION_BYTES = 7
+};
 
 extern "C"
 {
     /** Checks whether a YAML string represents a valid YAML document. */
     String* check_yaml(String* in_str);
+
+    /** Changes a limit that documents must observe to pass the check. */
+    bool check_configure(int option, std::size_t value);
 }
 
 /** Checks whether a YAML string represents a valid YAML document. */
@@ -54,34 +48,52 @@ String* check_yaml(String* in_str)
         s += 3;
     }
 
-    if (setjmp(parse_error_handler)) {
+    // parse YAML and emit JSON
+    std::string json;
+    if (!yaml::to_json(s, json, options)) {
+        const std::string& error_message = yaml::error_message();
         return new String(error_message.data(), error_message.size());
     }
 
-    // parse YAML
-    ryml::Tree tree = ryml::parse_in_place(s);
-
-    // emit JSON
-    std::string json = ryml::emitrs_json<std::string>(tree);
-
     // check if string is valid UTF-8
     std::size_t pos;
     if (!utf8::is_valid(json, pos)) {
-        std::string msg;
-        constexpr const char* fmt = "invalid UTF-8 character in JSON at offset %zu";
-        int count = std::snprintf(nullptr, 0, fmt, pos);
-        if (count >= 0) {
-            msg.resize(count + 1);
-            std::snprintf(msg.data(), msg.size(), fmt, pos);
-        }
-        return new String(msg.data(), msg.size());
+        const std::string& error_message = yaml::invalid_utf8(pos);
+        return new String(error_message.data(), error_message.size());
     }
 
     return nullptr;
 }
 
+/** Changes a limit that documents must observe to pass the check. */
+bool check_configure(int option, std::size_t value)
+{
+    switch (option) {
+    case OPTION_MAX_DEPTH:
+        options.emit.max_depth = static_cast<ryml::id_type>(value);
+        return true;
+    case OPTION_MAX_INPUT_BYTES:
+        options.max_input_bytes = value ? value : SIZE_MAX;
+        return true;
+    case OPTION_MAX_NODES:
+        options.max_nodes = value ? static_cast<ryml::id_type>(value) : ryml::NONE;
+        return true;
+    case OPTION_MAX_OUTPUT_BYTES:
+        options.emit.max_output_bytes = value ? value : SIZE_MAX;
+        return true;
+    case OPTION_EXPAND_ALIASES:
+        options.emit.expand_aliases = value != 0;
+        return true;
+    case OPTION_MAX_EXPANSION_BYTES:
+        options.emit.max_expansion_bytes = value ? value : SIZE_MAX;
+        return true;
+    default:
+        return false;
+    }
+}
+
 int main(int argc, const char* argv[])
 {
-    ryml::set_callbacks(ryml::Callbacks(nullptr, &parser_allocate, &parser_free, &parser_raise));
+    yaml::initialize();
     return 0;
 }
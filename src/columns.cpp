@@ -0,0 +1,177 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#include "columns.hpp"
+#include "utf8.hpp"
+#include <cstring>
+
+static bool same_segment(const path::Segment& a, const path::Segment& b)
+{
+    return a.is_index == b.is_index && (a.is_index ? a.index == b.index : a.key == b.key);
+}
+
+bool ColumnSet::compile(const char* paths, std::size_t len)
+{
+    _paths.assign(paths, len);
+    _nodes.clear();
+    _nodes.emplace_back();
+    _columns.clear();
+    _rows = 0;
+
+    std::vector<path::Segment> segments;
+    const char* p = _paths.data();
+    const char* end = p + _paths.size();
+    while (true) {
+        const char* separator = static_cast<const char*>(std::memchr(p, '\0', end - p));
+        const char* path_end = separator ? separator : end;
+        if (!path::parse(p, path_end - p, segments)) {
+            _nodes.clear();
+            _nodes.emplace_back();
+            _columns.clear();
+            return false;
+        }
+
+        // follow (or add) the trie node of each segment
+        std::uint32_t node = 0;
+        for (const path::Segment& segment : segments) {
+            std::uint32_t child = _nodes[node].first_child;
+            while (child != none && !same_segment(_nodes[child].segment, segment)) {
+                child = _nodes[child].next_sibling;
+            }
+            if (child == none) {
+                child = static_cast<std::uint32_t>(_nodes.size());
+                _nodes.emplace_back();
+                _nodes[child].segment = segment;
+                _nodes[child].next_sibling = _nodes[node].first_child;
+                _nodes[node].first_child = child;
+                ++_nodes[node].child_count;
+            }
+            node = child;
+        }
+        _nodes[node].columns.push_back(static_cast<std::uint32_t>(_columns.size()));
+        _columns.emplace_back();
+
+        if (!separator) {
+            break;
+        }
+        p = separator + 1;
+    }
+    return true;
+}
+
+void ColumnSet::extract(const ryml::Tree& tree, const json::EmitOptions& options)
+{
+    _pending.clear();
+    _pending.emplace_back(0, tree.root_id());
+    while (!_pending.empty()) {
+        std::uint32_t step = _pending.back().first;
+        ryml::id_type id = _pending.back().second;
+        _pending.pop_back();
+
+        const Node& node = _nodes[step];
+        for (std::uint32_t index : node.columns) {
+            Column& column = _columns[index];
+            std::size_t start = column.data.size();
+            json::emit(tree, id, column.data, options);
+            column.lengths.back() = static_cast<std::uint32_t>(column.data.size() - start);
+        }
+
+        // match children of the tree node against children of the trie node in a single pass; indexes only apply to
+        // sequences and keys only to maps, and the first of duplicate keys wins (as in `path::find`)
+        if (node.first_child == none || !tree.is_container(id)) {
+            continue;
+        }
+        bool is_seq = tree.is_seq(id);
+        std::uint32_t unmatched = node.child_count;
+        std::size_t position = 0;
+        for (ryml::id_type child = tree.first_child(id); child != ryml::NONE && unmatched > 0; child = tree.next_sibling(child), ++position) {
+            for (std::uint32_t next = node.first_child; next != none; next = _nodes[next].next_sibling) {
+                Node& candidate = _nodes[next];
+                if (candidate.matched_row == _rows || candidate.segment.is_index != is_seq) {
+                    continue;
+                }
+                if (path::matches(tree, child, position, candidate.segment)) {
+                    candidate.matched_row = _rows;
+                    --unmatched;
+                    _pending.emplace_back(next, child);
+                }
+            }
+        }
+    }
+}
+
+namespace
+{
+    /** Arguments of a function that parses a YAML string and extracts the values at the paths of a column set. */
+    struct ColumnExtraction
+    {
+        ColumnSet* columns;
+        char* str;
+        const yaml::Options* options;
+        bool is_stream;
+    };
+}
+
+static void parse_and_extract(void* data)
+{
+    ColumnExtraction* args = static_cast<ColumnExtraction*>(data);
+    const ryml::Tree& tree = yaml::parse(args->str, *args->options);
+    if (tree.is_stream(tree.root_id())) {
+        // a stream of multiple documents has no JSON representation
+        args->is_stream = true;
+        return;
+    }
+    args->columns->extract(tree, args->options->emit);
+}
+
+bool ColumnSet::add(char* str, const yaml::Options& options)
+{
+    for (Column& column : _columns) {
+        column.row_start = column.data.size();
+        column.lengths.push_back(missing);
+    }
+
+    ColumnExtraction args = { this, str, &options, false };
+    bool success = yaml::guard(&parse_and_extract, &args) && !args.is_stream;
+    for (Column& column : _columns) {
+        // drop cells of a failed row (including partial output), and cells that are not valid UTF-8
+        std::uint32_t& length = column.lengths.back();
+        std::size_t pos;
+        if (!success || (length != missing && !utf8::is_valid(column.data.data() + column.row_start, length, pos))) {
+            column.data.resize(column.row_start);
+            length = missing;
+        }
+    }
+    ++_rows;
+    return success;
+}
+
+static void write_u32(std::string& out, std::uint32_t value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void ColumnSet::write(std::string& out)
+{
+    write_u32(out, static_cast<std::uint32_t>(_columns.size()));
+    write_u32(out, static_cast<std::uint32_t>(_rows));
+    for (const Column& column : _columns) {
+        out.append(reinterpret_cast<const char*>(column.lengths.data()), column.lengths.size() * sizeof(std::uint32_t));
+    }
+    for (Column& column : _columns) {
+        out += column.data;
+        column.data.clear();
+        column.lengths.clear();
+    }
+
+    // rows of the next batch are numbered from zero again
+    for (Node& node : _nodes) {
+        node.matched_row = SIZE_MAX;
+    }
+    _rows = 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#pragma once
+#include "ryml_all.hpp"
+#include "json.hpp"
+#include "path.hpp"
+#include "yaml.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Extracts the values at a fixed set of paths from a batch of YAML documents, one column per path.
+ *
+ * Paths are compiled once into a trie, such that paths that share a prefix are resolved together, and all paths of a
+ * document are resolved in a single walk of its tree. Each column collects the JSON representation of the value at its
+ * path in successive rows.
+ */
+class ColumnSet
+{
+public:
+    /** Length of a cell that holds no value (the path does not refer to a node, or the document is malformed). */
+    static constexpr std::uint32_t missing = UINT32_MAX;
+
+    /**
+     * Compiles paths (see `path::parse`) separated by NUL characters into a trie, one column per path.
+     * @returns False if a path is malformed.
+     */
+    bool compile(const char* paths, std::size_t len);
+
+    /**
+     * Parses a YAML string in place, and appends a row with the value at each path.
+     * @returns False if the YAML string is malformed, exceeds a budget in `options`, or is a stream of documents, in
+     * which case all cells of the row are missing.
+     */
+    bool add(char* str, const yaml::Options& options);
+
+    /**
+     * Appends the batch of rows to a buffer, and starts a new batch.
+     *
+     * The buffer holds the number of columns and rows as 32-bit integers, the length of each cell column by column
+     * (`missing` for cells without a value), and the JSON text of all cells, column by column.
+     */
+    void write(std::string& out);
+
+    /** Writes the values at all paths of a parsed document into the current row. */
+    void extract(const ryml::Tree& tree, const json::EmitOptions& options);
+
+private:
+    /** Sentinel for the absence of a trie node. */
+    static constexpr std::uint32_t none = UINT32_MAX;
+
+    /** A step of one or more paths. */
+    struct Node
+    {
+        path::Segment segment;
+        std::uint32_t first_child = none;
+        std::uint32_t next_sibling = none;
+        std::uint32_t child_count = 0;
+        /** The row in which a tree node has last been matched to this step. */
+        std::size_t matched_row = SIZE_MAX;
+        /** Columns of the paths that end with this step. */
+        std::vector<std::uint32_t> columns;
+    };
+
+    struct Column
+    {
+        std::string data;
+        std::vector<std::uint32_t> lengths;
+        /** Size of `data` before the current row. */
+        std::size_t row_start = 0;
+    };
+
+    /** The paths that segments of the trie refer to. */
+    std::string _paths;
+    /** The trie of paths; the root stands for the empty path. */
+    std::vector<Node> _nodes;
+    std::vector<Column> _columns;
+    std::size_t _rows = 0;
+
+    /** Pairs of trie nodes and tree nodes yet to be visited, reused across documents. */
+    std::vector<std::pair<std::uint32_t, ryml::id_type>> _pending;
+};
@@ -0,0 +1,23 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * Converts a YAML string of `size` bytes, which is followed by a NUL character and is modified in place (e.g. a
+ * record in a private memory mapping), into a JSON string, bypassing the result cache and without copying input.
+ *
+ * Shares settings (see `transform_configure`) with the functions exported to Wasm, and is called by native hosts
+ * written in C++ (e.g. the command-line converter).
+ * @param threads Number of threads that convert a document that is a large top-level block sequence (see
+ * `split::to_json`), or 1 to convert on the calling thread only.
+ * @returns False if conversion has failed; see `yaml::error_message`.
+ */
+bool transform_yaml_in_place(char* str, std::size_t size, std::string& json, std::size_t threads);
@@ -0,0 +1,415 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#include "convert.hpp"
+#include "yaml.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// command-line converter of YAML files (each a stream of documents separated by `---`) to JSON lines, which calls the
+// same conversion function as the Wasm build
+//
+// Input files are mapped into memory privately, such that documents are parsed in place (pages that the parser
+// modifies are copied on write), and never copied otherwise. A reader thread splits files into documents, the main
+// thread converts them, and a writer thread writes JSON lines, with bounded queues of batches between them. A large
+// document that is a top-level sequence is converted in chunks on several threads (see `split::to_json`).
+
+/** Number of bytes of input after which a batch of documents is passed on to conversion. */
+constexpr std::size_t batch_bytes = 4 << 20;
+
+/** Number of batches each queue holds before the stage that feeds it waits. */
+constexpr std::size_t queue_capacity = 4;
+
+/** A queue of items passed from one thread to another, which blocks when full (or empty). */
+template <typename T>
+class Queue
+{
+public:
+    /** Appends an item, waiting while the queue is full. */
+    void push(T item)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_full.wait(lock, [this] { return _items.size() < queue_capacity; });
+        _items.push_back(std::move(item));
+        _not_empty.notify_one();
+    }
+
+    /**
+     * Removes an item, waiting while the queue is empty.
+     * @returns False if the queue is empty and closed.
+     */
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_empty.wait(lock, [this] { return !_items.empty() || _closed; });
+        if (_items.empty()) {
+            return false;
+        }
+        item = std::move(_items.front());
+        _items.pop_front();
+        _not_full.notify_one();
+        return true;
+    }
+
+    /** Removes all items (at least one), waiting while the queue is empty. */
+    bool pop_all(std::vector<T>& items)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_empty.wait(lock, [this] { return !_items.empty() || _closed; });
+        if (_items.empty()) {
+            return false;
+        }
+        for (T& item : _items) {
+            items.push_back(std::move(item));
+        }
+        _items.clear();
+        _not_full.notify_all();
+        return true;
+    }
+
+    /** Signals that no more items are coming. */
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closed = true;
+        _not_empty.notify_all();
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _not_full;
+    std::condition_variable _not_empty;
+    std::deque<T> _items;
+    bool _closed = false;
+};
+
+/** A file mapped into memory privately, which is unmapped when the last batch that refers to it is released. */
+class Mapping
+{
+public:
+    Mapping(char* data, std::size_t size)
+        : _data(data)
+        , _size(size)
+    {
+    }
+
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    ~Mapping()
+    {
+        munmap(_data, _size);
+    }
+
+private:
+    char* _data;
+    std::size_t _size;
+};
+
+/** A document in a mapped file (or in `Batch::copy`), followed by a NUL character. */
+struct Record
+{
+    char* data;
+    std::size_t size;
+};
+
+/** Documents passed from the reader to conversion. */
+struct Batch
+{
+    std::vector<Record> records;
+    /** Mapped files the records point into. */
+    std::vector<std::shared_ptr<Mapping>> mappings;
+    /** Last document of a file that has no room for a NUL character after it in its mapping. */
+    std::string copy;
+};
+
+/** JSON lines passed from conversion to the writer. */
+struct Output
+{
+    std::string lines;
+};
+
+/** True if a line is a document marker (`---` or `...`) followed by white space or the end of the line. */
+static bool is_marker(const char* p, const char* end, char c)
+{
+    return end - p >= 3 && p[0] == c && p[1] == c && p[2] == c && (end - p == 3 || p[3] == ' ' || p[3] == '\t' || p[3] == '\r' || p[3] == '\n');
+}
+
+/** True if a document is made up of blank lines and comments only (e.g. text before the first `---`). */
+static bool is_blank(const char* p, const char* end)
+{
+    bool comment = false;
+    for (; p != end; ++p) {
+        if (*p == '\n') {
+            comment = false;
+        } else if (*p == '#') {
+            comment = true;
+        } else if (!comment && *p != ' ' && *p != '\t' && *p != '\r') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Statistics reported at the end of a run. */
+struct Totals
+{
+    std::size_t input_bytes = 0;
+    std::size_t output_bytes = 0;
+    std::size_t documents = 0;
+    std::size_t errors = 0;
+};
+
+/**
+ * Maps files into memory, and splits them into documents at lines that start with a document marker.
+ *
+ * Document markers always start a line (they may not appear in block scalars or quoted strings at the start of a
+ * line), such that splitting needs no parsing. Directives (e.g. `%YAML 1.2`) before the marker that starts a document
+ * are skipped. The line break before a marker is overwritten with a NUL character, which terminates the document before
+ * it.
+ */
+static bool read_files(const std::vector<const char*>& paths, Queue<std::unique_ptr<Batch>>& batches, Totals& totals)
+{
+    bool success = true;
+    std::unique_ptr<Batch> batch(new Batch());
+    std::size_t bytes = 0;
+    for (const char* path : paths) {
+        int fd = open(path, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) < 0) {
+            std::perror(path);
+            if (fd >= 0) {
+                close(fd);
+            }
+            success = false;
+            continue;
+        }
+        std::size_t size = static_cast<std::size_t>(st.st_size);
+        if (size == 0) {
+            close(fd);
+            continue;
+        }
+        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            std::perror(path);
+            success = false;
+            continue;
+        }
+        madvise(addr, size, MADV_SEQUENTIAL);
+        char* data = static_cast<char*>(addr);
+        std::shared_ptr<Mapping> mapping = std::make_shared<Mapping>(data, size);
+        batch->mappings.push_back(mapping);
+        totals.input_bytes += size;
+
+        char* end = data + size;
+        char* start = data;
+        char* line = data;
+        while (start != end) {
+            // find the start of the next document, and the end of the current one
+            char* next = end;
+            char* stop = end;
+            bool prefix = true;  // only directives, comments and blank lines so far
+            bool directives = false;
+            for (; line != end; ) {
+                char* eol = static_cast<char*>(std::memchr(line, '\n', end - line));
+                char* line_end = eol ? eol : end;
+                if (is_marker(line, line_end, '-')) {
+                    if (line != start && !(prefix && directives)) {
+                        stop = line;
+                        next = line;
+                        break;
+                    }
+                    if (directives) {
+                        // the document starts at the marker, as directives do not affect JSON output
+                        start = line;
+                    }
+                    prefix = false;
+                } else if (prefix && *line == '%') {
+                    directives = true;
+                } else if (prefix && !is_blank(line, line_end)) {
+                    prefix = false;
+                }
+                if (is_marker(line, line_end, '.')) {
+                    stop = line;
+                    next = eol ? eol + 1 : end;
+                    line = next;
+                    break;
+                }
+                line = eol ? eol + 1 : end;
+            }
+
+            if (!is_blank(start, stop)) {
+                if (stop != end) {
+                    // the line break before a marker
+                    stop[-1] = '\0';
+                    batch->records.push_back({ start, static_cast<std::size_t>(stop - 1 - start) });
+                } else if (size % static_cast<std::size_t>(sysconf(_SC_PAGESIZE)) != 0) {
+                    // the rest of the last page of a mapping is filled with zeros
+                    batch->records.push_back({ start, static_cast<std::size_t>(stop - start) });
+                } else {
+                    batch->copy.assign(start, stop - start);
+                    batch->records.push_back({ &batch->copy[0], batch->copy.size() });
+                }
+                bytes += stop - start;
+            }
+            start = next;
+
+            if (bytes >= batch_bytes || !batch->copy.empty()) {
+                batches.push(std::move(batch));
+                batch.reset(new Batch());
+                if (start != end) {
+                    batch->mappings.push_back(mapping);
+                }
+                bytes = 0;
+            }
+        }
+    }
+    batches.push(std::move(batch));
+    batches.close();
+    return success;
+}
+
+/** Converts batches of documents into JSON lines (`null` for documents that are empty or fail to convert). */
+static void convert_batches(Queue<std::unique_ptr<Batch>>& batches, Queue<std::unique_ptr<Output>>& outputs, std::size_t threads, Totals& totals)
+{
+    std::string json;
+    std::unique_ptr<Batch> batch;
+    while (batches.pop(batch)) {
+        std::unique_ptr<Output> output(new Output());
+        for (std::size_t i = 0; i < batch->records.size(); ++i) {
+            const Record& record = batch->records[i];
+            if (transform_yaml_in_place(record.data, record.size, json, threads)) {
+                // an empty document (e.g. `---` followed by comments only) has an empty JSON string
+                output->lines += json.empty() ? "null" : json;
+            } else {
+                // documents are numbered from 1 across all input files, as are lines of output
+                std::fprintf(stderr, "document %zu: %s\n", totals.documents + i + 1, yaml::error_message().c_str());
+                output->lines += "null";
+                ++totals.errors;
+            }
+            output->lines += '\n';
+        }
+        totals.documents += batch->records.size();
+
+        // unmap files as soon as all of their documents are converted
+        batch.reset();
+        outputs.push(std::move(output));
+    }
+    outputs.close();
+}
+
+/** Writes JSON lines, gathering all batches that are ready into a single system call. */
+static bool write_outputs(int fd, Queue<std::unique_ptr<Output>>& outputs, Totals& totals)
+{
+    bool success = true;
+    std::vector<std::unique_ptr<Output>> ready;
+    std::vector<struct iovec> vectors;
+    while (outputs.pop_all(ready)) {
+        for (const std::unique_ptr<Output>& output : ready) {
+            if (!output->lines.empty()) {
+                vectors.push_back({ &output->lines[0], output->lines.size() });
+            }
+            totals.output_bytes += output->lines.size();
+        }
+        std::size_t first = 0;
+        while (success && first < vectors.size()) {
+            int count = static_cast<int>(std::min<std::size_t>(vectors.size() - first, IOV_MAX));
+            ssize_t written = writev(fd, &vectors[first], count);
+            if (written < 0) {
+                std::perror("write");
+                success = false;
+                break;
+            }
+
+            // skip what has been written, and continue with the rest of a partially written buffer
+            std::size_t remaining = static_cast<std::size_t>(written);
+            while (first < vectors.size() && remaining >= vectors[first].iov_len) {
+                remaining -= vectors[first].iov_len;
+                ++first;
+            }
+            if (remaining > 0) {
+                vectors[first].iov_base = static_cast<char*>(vectors[first].iov_base) + remaining;
+                vectors[first].iov_len -= remaining;
+            }
+        }
+        vectors.clear();
+        ready.clear();
+    }
+    return success;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* output_path = nullptr;
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = std::max(1L, std::strtol(argv[++i], nullptr, 10));
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        std::fprintf(stderr, "usage: %s [-o output.jsonl] [-j threads] input.yaml...\n", argv[0]);
+        return 2;
+    }
+
+    int fd = STDOUT_FILENO;
+    if (output_path) {
+        fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::perror(output_path);
+            return 1;
+        }
+    }
+
+    yaml::initialize();
+    auto start = std::chrono::steady_clock::now();
+
+    Totals totals;
+    Queue<std::unique_ptr<Batch>> batches;
+    Queue<std::unique_ptr<Output>> outputs;
+    bool read_success = true;
+    bool write_success = true;
+    std::thread reader([&] { read_success = read_files(paths, batches, totals); });
+    std::thread writer([&] { write_success = write_outputs(fd, outputs, totals); });
+    convert_batches(batches, outputs, threads, totals);
+    reader.join();
+    writer.join();
+    if (output_path) {
+        close(fd);
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "%zu documents (%zu failed), %.1f MB in, %.1f MB out, %.3f s, %.1f MB/s\n",
+        totals.documents, totals.errors, totals.input_bytes / 1048576.0, totals.output_bytes / 1048576.0, elapsed,
+        elapsed > 0 ? totals.input_bytes / 1048576.0 / elapsed : 0.0);
+    return read_success && write_success ? 0 : 1;
+}
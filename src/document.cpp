@@ -0,0 +1,151 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#include "document.hpp"
+#include "path.hpp"
+#include <vector>
+
+/** Largest generation count, such that handles do not overflow (and generation zero is never used). */
+constexpr std::uint32_t max_generation = UINT32_MAX / DocumentTable::capacity - 1;
+
+std::uint32_t DocumentTable::open(String* source, char* str, const yaml::Options& options)
+{
+    for (std::size_t index = 0; index < capacity; ++index) {
+        Slot& slot = _slots[index];
+        if (slot.source) {
+            continue;
+        }
+
+        if (!yaml::to_tree(str, slot.tree, options)) {
+            delete source;
+            return 0;
+        }
+        slot.source = source;
+        slot.generation = slot.generation < max_generation ? slot.generation + 1 : 1;
+        return slot.generation * capacity + index;
+    }
+
+    // all slots are in use
+    delete source;
+    return 0;
+}
+
+void DocumentTable::close(std::uint32_t handle)
+{
+    if (!this->slot(handle)) {
+        return;
+    }
+    Slot& slot = _slots[handle % capacity];
+    slot.tree = ryml::Tree();
+    delete slot.source;
+    slot.source = nullptr;
+}
+
+const DocumentTable::Slot* DocumentTable::slot(std::uint32_t handle) const
+{
+    const Slot& slot = _slots[handle % capacity];
+    if (!slot.source || slot.generation != handle / capacity) {
+        return nullptr;
+    }
+    return &slot;
+}
+
+std::size_t DocumentTable::size() const
+{
+    std::size_t count = 0;
+    for (const Slot& slot : _slots) {
+        if (slot.source) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+/** Segments of the last path looked up, reused across calls. */
+static thread_local std::vector<path::Segment> segments;
+
+const ryml::Tree* DocumentTable::find(std::uint32_t handle, const char* path, std::size_t len, ryml::id_type& node) const
+{
+    const Slot* slot = this->slot(handle);
+    if (!slot || slot->tree.empty()) {
+        return nullptr;
+    }
+    const ryml::Tree& tree = slot->tree;
+    ryml::id_type root = tree.root_id();
+    if (tree.is_stream(root)) {
+        // a stream of multiple documents has no JSON representation
+        return nullptr;
+    }
+
+    if (!path::parse(path, len, segments)) {
+        return nullptr;
+    }
+    ryml::id_type id = path::find(tree, root, segments.data(), segments.data() + segments.size());
+    if (id == ryml::NONE) {
+        return nullptr;
+    }
+
+    node = id;
+    return &tree;
+}
+
+DocumentType document_type(const ryml::Tree& tree, ryml::id_type node)
+{
+    if (tree.is_seq(node)) {
+        return DocumentType::array;
+    } else if (tree.is_map(node)) {
+        return DocumentType::object;
+    }
+
+    // same rules as the JSON writer
+    ryml::type_bits flags = tree.type(node).type;
+    ryml::csubstr scalar = tree.valsc(node).scalar;
+    if (scalar.len) {
+        if (flags & ryml::VALQUO) {
+            return DocumentType::string;
+        }
+        switch (json::classify(scalar.str, scalar.len)) {
+        case json::ScalarKind::number:
+            return DocumentType::number;
+        case json::ScalarKind::boolean:
+            return DocumentType::boolean;
+        case json::ScalarKind::null:
+            return DocumentType::null;
+        default:
+            return DocumentType::string;
+        }
+    } else if (scalar.str || (flags & (ryml::VALQUO | ryml::VALTAG))) {
+        return DocumentType::string;
+    } else {
+        return DocumentType::null;
+    }
+}
+
+namespace
+{
+    /** Arguments of a function that writes a node of an open document as JSON. */
+    struct NodeConversion
+    {
+        const ryml::Tree* tree;
+        ryml::id_type node;
+        std::string* json;
+        const json::EmitOptions* options;
+    };
+}
+
+static void emit_node(void* data)
+{
+    NodeConversion* args = static_cast<NodeConversion*>(data);
+    json::emit(*args->tree, args->node, *args->json, *args->options);
+}
+
+bool document_to_json(const ryml::Tree& tree, ryml::id_type node, std::string& json, const json::EmitOptions& options)
+{
+    NodeConversion args = { &tree, node, &json, &options };
+    return yaml::guard(&emit_node, &args);
+}
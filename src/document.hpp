@@ -0,0 +1,90 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#pragma once
+#include "ryml_all.hpp"
+#include "json.hpp"
+#include "string.hpp"
+#include "yaml.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/** The JSON value type of a node in an open document. */
+enum class DocumentType : int
+{
+    /** The path does not refer to a node. */
+    missing = 0,
+    null = 1,
+    boolean = 2,
+    number = 3,
+    string = 4,
+    array = 5,
+    object = 6
+};
+
+/**
+ * A bounded table of parsed YAML documents, kept resident for repeated lookups by path.
+ *
+ * A handle combines the index of a slot with a generation count, such that a handle that has been closed is not
+ * mistaken for a document that has later been opened in the same slot. Zero is never a valid handle.
+ * Nodes are looked up by path (see `path::parse`).
+ */
+class DocumentTable
+{
+public:
+    /** Maximum number of documents open at the same time. */
+    static constexpr std::size_t capacity = 16;
+
+    /**
+     * Parses a YAML string in place, and keeps its tree.
+     *
+     * Takes ownership of `source`, which the tree refers to, and which is released when the document is closed (or
+     * immediately if parsing fails). Parsing starts at `str`, which points into `source`.
+     * @returns A handle, or zero if the YAML string is malformed, exceeds a budget in `options`, or all slots are in use.
+     */
+    std::uint32_t open(String* source, char* str, const yaml::Options& options);
+
+    /** Releases the tree and source of a document. Unknown handles are ignored. */
+    void close(std::uint32_t handle);
+
+    /**
+     * Finds a node in an open document.
+     *
+     * @param node Set to the node the path refers to.
+     * @returns The tree of the document, or null if the handle is unknown or the path does not refer to a node.
+     */
+    const ryml::Tree* find(std::uint32_t handle, const char* path, std::size_t len, ryml::id_type& node) const;
+
+    /** Number of open documents. */
+    std::size_t size() const;
+
+private:
+    struct Slot
+    {
+        ryml::Tree tree;
+        /** The YAML string the tree refers to, or null if the slot is free. */
+        String* source = nullptr;
+        std::uint32_t generation = 0;
+    };
+
+    /** Looks up the slot a handle refers to, or null if the handle is unknown. */
+    const Slot* slot(std::uint32_t handle) const;
+
+    Slot _slots[capacity];
+};
+
+/** Classifies a node as the JSON value it is written as (aliases are strings). */
+DocumentType document_type(const ryml::Tree& tree, ryml::id_type node);
+
+/**
+ * Appends the JSON representation of a node (without its key) to a buffer.
+ *
+ * @returns False if a budget in `options` is exceeded; see `yaml::error_message`.
+ */
+bool document_to_json(const ryml::Tree& tree, ryml::id_type node, std::string& json, const json::EmitOptions& options);
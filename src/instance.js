@@ -0,0 +1,65 @@
+/**
+ * Recycles Wasm instances to keep memory use and latency steady in long-running sessions.
+ *
+ * Wasm linear memory never shrinks: after a few very large rows, the heap stays grown (and fragmented) for as long as
+ * the instance lives. Wasm code is compiled once into a `WebAssembly.Module`, and a fresh (cheap to create) instance
+ * of the compiled module replaces the current instance when its heap exceeds a size threshold, or after it has served
+ * a number of rows.
+ */
+
+/** Number of rows an instance serves before it is replaced. */
+const INSTANCE_MAX_ROWS = 100000;
+
+/** Size of the heap (in bytes) beyond which an instance is replaced. */
+const INSTANCE_MAX_HEAP = 128 * 1024 * 1024;
+
+/**
+ * Creates a new instance of an Emscripten module.
+ *
+ * @param {function(Object, Object)} setup Runs Emscripten output with a module object and a `WebAssembly` namespace.
+ * @param {Object} [previous] The module object of the instance to replace, whose compiled Wasm code is re-used.
+ * @returns {Object} The module object of the new instance.
+ */
+function create_instance(setup, previous) {
+    const recycler = previous ? previous.recycler : { compiled: null, rows: 0, resets: -1 };
+    recycler.rows = 0;
+    recycler.resets += 1;
+
+    const Module = { "recycler": recycler };
+    if (recycler.compiled) {
+        // skip decoding the Wasm binary embedded in Emscripten output, which would not be compiled anyway
+        Module["wasmBinary"] = new Uint8Array(0);
+    }
+
+    // Emscripten output compiles Wasm code with `new WebAssembly.Module`, which is intercepted to capture the
+    // compiled module on first use, and substitute it afterwards
+    const wasm = Object.create(WebAssembly);
+    wasm.Module = function (binary) {
+        if (!recycler.compiled) {
+            recycler.compiled = new WebAssembly.Module(binary);
+        }
+        return recycler.compiled;
+    };
+
+    setup(Module, wasm);
+    return Module;
+}
+
+/**
+ * Returns the module object to serve the next row with, replacing the current instance if it has exceeded its limits.
+ *
+ * @param {function(Object, Object)} setup Runs Emscripten output with a module object and a `WebAssembly` namespace.
+ * @param {Object} [current] The module object of the current instance, if any.
+ * @returns {Object} The module object to use.
+ */
+function acquire_instance(setup, current) {
+    if (!current || current.recycler.rows >= INSTANCE_MAX_ROWS || current.heap_size() >= INSTANCE_MAX_HEAP) {
+        current = create_instance(setup, current);
+    }
+    current.recycler.rows += 1;
+    return current;
+}
+
+if (typeof module != "undefined") {
+    module["exports"] = { "create_instance": create_instance, "acquire_instance": acquire_instance, "INSTANCE_MAX_ROWS": INSTANCE_MAX_ROWS };
+}
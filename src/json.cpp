@@ -0,0 +1,927 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#include "json.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/** True for characters that must be escaped in a JSON string. */
+static constexpr bool needs_escape(unsigned char c)
+{
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+/** Character classes of the JSON number grammar. */
+enum NumberClass : unsigned char
+{
+    NC_ZERO,
+    NC_DIGIT,
+    NC_MINUS,
+    NC_PLUS,
+    NC_POINT,
+    NC_EXP,
+    NC_OTHER,
+    NC_COUNT
+};
+
+/** States of the deterministic finite automaton that recognizes a JSON number. */
+enum NumberState : unsigned char
+{
+    NS_START,
+    NS_SIGN,
+    NS_ZERO,
+    NS_INTEGER,
+    NS_POINT,
+    NS_FRACTION,
+    NS_EXP,
+    NS_EXP_SIGN,
+    NS_EXPONENT,
+    NS_REJECT,
+    NS_COUNT
+};
+
+struct NumberClassTable
+{
+    unsigned char classes[256];
+
+    constexpr NumberClassTable()
+        : classes()
+    {
+        for (int c = 0; c < 256; ++c) {
+            classes[c] = NC_OTHER;
+        }
+        classes[static_cast<unsigned char>('0')] = NC_ZERO;
+        for (int c = '1'; c <= '9'; ++c) {
+            classes[c] = NC_DIGIT;
+        }
+        classes[static_cast<unsigned char>('-')] = NC_MINUS;
+        classes[static_cast<unsigned char>('+')] = NC_PLUS;
+        classes[static_cast<unsigned char>('.')] = NC_POINT;
+        classes[static_cast<unsigned char>('e')] = NC_EXP;
+        classes[static_cast<unsigned char>('E')] = NC_EXP;
+    }
+};
+
+static constexpr NumberClassTable number_classes;
+
+static constexpr unsigned char number_transitions[NS_COUNT][NC_COUNT] = {
+    //               0            1-9          -            +            .          e/E        other
+    /* START    */ { NS_ZERO,     NS_INTEGER,  NS_SIGN,     NS_REJECT,   NS_REJECT, NS_REJECT, NS_REJECT },
+    /* SIGN     */ { NS_ZERO,     NS_INTEGER,  NS_REJECT,   NS_REJECT,   NS_REJECT, NS_REJECT, NS_REJECT },
+    /* ZERO     */ { NS_REJECT,   NS_REJECT,   NS_REJECT,   NS_REJECT,   NS_POINT,  NS_EXP,    NS_REJECT },
+    /* INTEGER  */ { NS_INTEGER,  NS_INTEGER,  NS_REJECT,   NS_REJECT,   NS_POINT,  NS_EXP,    NS_REJECT },
+    /* POINT    */ { NS_FRACTION, NS_FRACTION, NS_REJECT,   NS_REJECT,   NS_REJECT, NS_REJECT, NS_REJECT },
+    /* FRACTION */ { NS_FRACTION, NS_FRACTION, NS_REJECT,   NS_REJECT,   NS_REJECT, NS_EXP,    NS_REJECT },
+    /* EXP      */ { NS_EXPONENT, NS_EXPONENT, NS_EXP_SIGN, NS_EXP_SIGN, NS_REJECT, NS_REJECT, NS_REJECT },
+    /* EXP_SIGN */ { NS_EXPONENT, NS_EXPONENT, NS_REJECT,   NS_REJECT,   NS_REJECT, NS_REJECT, NS_REJECT },
+    /* EXPONENT */ { NS_EXPONENT, NS_EXPONENT, NS_REJECT,   NS_REJECT,   NS_REJECT, NS_REJECT, NS_REJECT },
+    /* REJECT   */ { NS_REJECT,   NS_REJECT,   NS_REJECT,   NS_REJECT,   NS_REJECT, NS_REJECT, NS_REJECT },
+};
+
+/** Runs the number automaton on a string. */
+static bool is_number(const char* str, std::size_t len)
+{
+    unsigned char state = NS_START;
+    for (std::size_t i = 0; i < len && state != NS_REJECT; ++i) {
+        state = number_transitions[state][number_classes.classes[static_cast<unsigned char>(str[i])]];
+    }
+    switch (state) {
+    case NS_ZERO:
+    case NS_INTEGER:
+    case NS_FRACTION:
+    case NS_EXPONENT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+json::ScalarKind json::classify(const char* str, std::size_t len)
+{
+    switch (str[0]) {
+    case 't':
+        return len == 4 && std::memcmp(str, "true", 4) == 0 ? ScalarKind::boolean : ScalarKind::string;
+    case 'f':
+        return len == 5 && std::memcmp(str, "false", 5) == 0 ? ScalarKind::boolean : ScalarKind::string;
+    case 'n':
+        return len == 4 && std::memcmp(str, "null", 4) == 0 ? ScalarKind::null : ScalarKind::string;
+    }
+
+    // most strings are rejected on the first character, which makes the scan cheap even for long scalars
+    return is_number(str, len) ? ScalarKind::number : ScalarKind::string;
+}
+
+const char* json::find_escape(const char* begin, const char* end)
+{
+    const char* p = begin;
+
+#if SIMD_WIDTH > 0
+    const simd::bytes quote = simd::splat('"');
+    const simd::bytes backslash = simd::splat('\\');
+    const simd::bytes control = simd::splat(0x1F);
+    while (end - p >= SIMD_WIDTH) {
+        simd::bytes v = simd::load(p);
+        std::uint32_t mask = simd::bitmask(simd::bit_or(simd::bit_or(simd::eq(v, quote), simd::eq(v, backslash)), simd::le(v, control)));
+        if (mask != 0) {
+            return p + simd::first_set(mask);
+        }
+        p += SIMD_WIDTH;
+    }
+#endif
+
+    while (p != end && !needs_escape(static_cast<unsigned char>(*p))) {
+        ++p;
+    }
+    return p;
+}
+
+/** Appends the escape sequence of a single character. */
+static void write_escape(std::string& out, unsigned char c)
+{
+    switch (c) {
+    case '"':
+        out.append("\\\"", 2);
+        break;
+    case '\\':
+        out.append("\\\\", 2);
+        break;
+    case '\b':
+        out.append("\\b", 2);
+        break;
+    case '\f':
+        out.append("\\f", 2);
+        break;
+    case '\n':
+        out.append("\\n", 2);
+        break;
+    case '\r':
+        out.append("\\r", 2);
+        break;
+    case '\t':
+        out.append("\\t", 2);
+        break;
+    default:
+    {
+        static const char hex[] = "0123456789abcdef";
+        const char seq[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+        out.append(seq, sizeof(seq));
+        break;
+    }
+    }
+}
+
+void json::write_string(std::string& out, const char* str, std::size_t len)
+{
+    const char* end = str + len;
+    out.reserve(out.size() + len + 2);
+    out.push_back('"');
+    while (true) {
+        const char* p = find_escape(str, end);
+        out.append(str, p - str);
+        if (p == end) {
+            break;
+        }
+        write_escape(out, static_cast<unsigned char>(*p));
+        str = p + 1;
+    }
+    out.push_back('"');
+}
+
+static inline bool is_json_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline const char* skip_space(const char* p, const char* end)
+{
+    while (p != end && is_json_space(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+static inline int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    } else {
+        return -1;
+    }
+}
+
+/** Parses the 4 hexadecimal digits of a `\uXXXX` escape sequence. */
+static inline long parse_code_unit(const char* p, const char* end)
+{
+    if (end - p < 4) {
+        return -1;
+    }
+    long value = 0;
+    for (int i = 0; i < 4; ++i) {
+        int digit = hex_value(p[i]);
+        if (digit < 0) {
+            return -1;
+        }
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+/**
+ * Scans a JSON string that starts at the opening quotation mark.
+ * @returns Pointer past the closing quotation mark, or null if the string is malformed.
+ */
+static const char* scan_string(const char* p, const char* end)
+{
+    ++p;
+    while (true) {
+        p = json::find_escape(p, end);
+        if (p == end) {
+            return nullptr;
+        }
+        switch (*p) {
+        case '"':
+            return p + 1;
+        case '\\':
+            break;
+        default:
+            // unescaped control character
+            return nullptr;
+        }
+
+        if (end - p < 2) {
+            return nullptr;
+        }
+        switch (p[1]) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+            p += 2;
+            break;
+        case 'u':
+        {
+            long unit = parse_code_unit(p + 2, end);
+            if (unit < 0 || (unit >= 0xDC00 && unit <= 0xDFFF)) {
+                return nullptr;
+            }
+            p += 6;
+            if (unit >= 0xD800 && unit <= 0xDBFF) {
+                // high surrogate must be followed by a low surrogate
+                if (end - p < 2 || p[0] != '\\' || p[1] != 'u') {
+                    return nullptr;
+                }
+                long low = parse_code_unit(p + 2, end);
+                if (low < 0xDC00 || low > 0xDFFF) {
+                    return nullptr;
+                }
+                p += 6;
+            }
+            break;
+        }
+        default:
+            return nullptr;
+        }
+    }
+}
+
+/**
+ * Scans a JSON literal or number.
+ * @returns Pointer past the token, or null if the token is malformed.
+ */
+static const char* scan_primitive(const char* p, const char* end)
+{
+    const char* start = p;
+    while (p != end && (std::isalnum(static_cast<unsigned char>(*p)) || *p == '-' || *p == '+' || *p == '.')) {
+        ++p;
+    }
+    std::size_t len = p - start;
+    if (len == 0) {
+        return nullptr;
+    }
+    switch (json::classify(start, len)) {
+    case json::ScalarKind::number:
+    case json::ScalarKind::boolean:
+    case json::ScalarKind::null:
+        return p;
+    default:
+        return nullptr;
+    }
+}
+
+bool json::looks_like_json(const char* str, std::size_t len)
+{
+    const char* p = skip_space(str, str + len);
+    return p != str + len && (*p == '{' || *p == '[');
+}
+
+/** Closing brackets of open containers in `minify`, reused across calls. */
+static thread_local std::string minify_stack;
+
+bool json::minify(const char* str, std::size_t len, std::string& out, ryml::id_type max_depth, ryml::id_type max_values)
+{
+    const char* p = str;
+    const char* end = str + len;
+
+    // closing bracket of each open container, `}` for objects and `]` for arrays
+    std::string& stack = minify_stack;
+    stack.clear();
+
+    out.reserve(out.size() + len);
+    ryml::id_type values = 0;
+    bool expect_key = false;
+    while (true) {
+        // parse a value or an object member
+        p = skip_space(p, end);
+        if (p == end) {
+            return false;
+        }
+        if (expect_key) {
+            if (*p != '"') {
+                return false;
+            }
+            const char* key_end = scan_string(p, end);
+            if (!key_end) {
+                return false;
+            }
+            out.append(p, key_end - p);
+            p = skip_space(key_end, end);
+            if (p == end || *p != ':') {
+                return false;
+            }
+            out.append(": ", 2);
+            p = skip_space(p + 1, end);
+            if (p == end) {
+                return false;
+            }
+        }
+        if (stack.size() > max_depth || ++values > max_values) {
+            return false;
+        }
+
+        if (*p == '{' || *p == '[') {
+            bool is_object = *p == '{';
+            char closing = is_object ? '}' : ']';
+            out.push_back(*p);
+            p = skip_space(p + 1, end);
+            if (p == end || *p != closing) {
+                stack.push_back(closing);
+                expect_key = is_object;
+                continue;
+            }
+
+            // empty container
+            out.push_back(*p);
+            ++p;
+        } else {
+            const char* value_end = *p == '"' ? scan_string(p, end) : scan_primitive(p, end);
+            if (!value_end) {
+                return false;
+            }
+            out.append(p, value_end - p);
+            p = value_end;
+        }
+
+        // close containers that end after the value
+        while (true) {
+            p = skip_space(p, end);
+            if (stack.empty()) {
+                return p == end;
+            }
+            if (p == end) {
+                return false;
+            }
+            char closing = stack.back();
+            if (*p == ',') {
+                out.push_back(',');
+                ++p;
+                expect_key = closing == '}';
+                break;
+            } else if (*p == closing) {
+                out.push_back(*p);
+                ++p;
+                stack.pop_back();
+            } else {
+                return false;
+            }
+        }
+    }
+}
+
+[[noreturn]] static void raise(const ryml::Tree& tree, const char* msg)
+{
+    const ryml::Callbacks& cb = tree.callbacks();
+    cb.m_error(msg, std::strlen(msg), ryml::Location(std::size_t(0), std::size_t(0), std::size_t(0)), cb.m_user_data);
+    std::abort();  // error callback must not return
+}
+
+/** Writes a key or value scalar (with the flags of the other part of the node masked off). */
+static void write_scalar(std::string& out, const ryml::NodeScalar& sc, ryml::type_bits flags)
+{
+    if (sc.scalar.len) {
+        // use double quotes for keys, quoted scalars, and plain scalars that are not a JSON literal or number
+        bool dquoted = (flags & (ryml::KEY | ryml::VALQUO)) || json::classify(sc.scalar.str, sc.scalar.len) == json::ScalarKind::string;
+        if (dquoted) {
+            json::write_string(out, sc.scalar.str, sc.scalar.len);
+        } else {
+            out.append(sc.scalar.str, sc.scalar.len);
+        }
+    } else if (sc.scalar.str || (flags & (ryml::KEY | ryml::VALQUO | ryml::KEYTAG | ryml::VALTAG))) {
+        out.append("\"\"", 2);
+    } else {
+        out.append("null", 4);
+    }
+}
+
+static void write_key(std::string& out, const ryml::Tree& tree, ryml::id_type id)
+{
+    write_scalar(out, tree.keysc(id), tree.type(id).type & ~ryml::VAL);
+}
+
+static void write_val(std::string& out, const ryml::Tree& tree, ryml::id_type id)
+{
+    write_scalar(out, tree.valsc(id), tree.type(id).type & ~ryml::KEY);
+}
+
+void json::write_member_key(std::string& out, const ryml::Tree& tree, ryml::id_type node)
+{
+    write_key(out, tree, node);
+    out.append(": ", 2);
+}
+
+/**
+ * Writes the key (if any, and if requested) and the value of a scalar node, or the key (if any, and if requested) and
+ * opening bracket of a container.
+ */
+static void write_open(std::string& out, const ryml::Tree& tree, ryml::id_type id, bool with_key)
+{
+    if (tree.is_keyval(id)) {
+        if (with_key) {
+            write_key(out, tree, id);
+            out.append(": ", 2);
+        }
+        write_val(out, tree, id);
+    } else if (tree.is_val(id)) {
+        write_val(out, tree, id);
+    } else if (tree.is_container(id)) {
+        if (with_key && tree.has_key(id)) {
+            write_key(out, tree, id);
+            out.append(": ", 2);
+        }
+        if (tree.is_seq(id)) {
+            out.push_back('[');
+        } else if (tree.is_map(id)) {
+            out.push_back('{');
+        }
+    }
+}
+
+/** Writes the closing bracket of a container. */
+static void write_close(std::string& out, const ryml::Tree& tree, ryml::id_type id)
+{
+    if (tree.is_seq(id)) {
+        out.push_back(']');
+    } else if (tree.is_map(id)) {
+        out.push_back('}');
+    }
+}
+
+/** Walks a subtree in document order and writes JSON, with aliases written verbatim as strings. */
+static void emit_tree(const ryml::Tree& tree, ryml::id_type node, std::string& out, const json::EmitOptions& options)
+{
+    // walk the tree without recursion, following parent links back up, such that the (small) Wasm stack does not
+    // limit nesting depth
+    std::size_t start = out.size();
+    ryml::id_type id = node;
+    ryml::id_type depth = 0;
+    while (true) {
+        if (depth > options.max_depth) {
+            raise(tree, "max depth exceeded");
+        }
+        // the key of the subtree root belongs to its parent
+        write_open(out, tree, id, depth > 0);
+        if (out.size() - start > options.max_output_bytes) {
+            raise(tree, "max output bytes exceeded");
+        }
+
+        ryml::id_type child = tree.first_child(id);
+        if (child != ryml::NONE) {
+            id = child;
+            ++depth;
+            continue;
+        }
+        write_close(out, tree, id);
+
+        // close containers whose last child has been written
+        while (true) {
+            if (depth == 0) {
+                if (out.size() - start > options.max_output_bytes) {
+                    raise(tree, "max output bytes exceeded");
+                }
+                return;
+            }
+            ryml::id_type sibling = tree.next_sibling(id);
+            if (sibling != ryml::NONE) {
+                out.push_back(',');
+                id = sibling;
+                break;
+            }
+            id = tree.parent(id);
+            --depth;
+            write_close(out, tree, id);
+        }
+    }
+}
+
+namespace
+{
+    /** The node an alias refers to. */
+    struct Target
+    {
+        ryml::id_type id = ryml::NONE;
+        /** True if the anchor is on the key of the node rather than its value. */
+        bool key = false;
+    };
+
+    /** An anchor visible at some point in the document. */
+    struct Anchor
+    {
+        ryml::csubstr name;
+        Target target;
+    };
+
+    /** A node to write, whose content may come from another node. */
+    struct Item
+    {
+        ryml::id_type id;
+        /** True if the node is written on behalf of an alias or merge key. */
+        bool expanded;
+    };
+
+    /** A container being written, whose items are `items[next..end)`. */
+    struct Frame
+    {
+        ryml::id_type content;
+        std::size_t begin;
+        std::size_t next;
+        std::size_t end;
+    };
+
+    /** State of writing a tree with aliases expanded, reused across calls. */
+    struct Expansion
+    {
+        /** Node each alias refers to, indexed by the node that has the alias as key or value, respectively. */
+        std::vector<Target> key_targets;
+        std::vector<Target> val_targets;
+        std::vector<Anchor> anchors;
+        std::vector<Item> items;
+        std::vector<Frame> frames;
+        /** Stack of maps whose entries are to be merged into a map, the next one on top. */
+        std::vector<ryml::id_type> sources;
+        /** Maps already merged from (and the map being merged into). */
+        std::unordered_set<ryml::id_type> merged;
+        /** Keys of the items of the map being merged into. */
+        std::unordered_set<std::string_view> keys;
+    };
+}
+
+static thread_local Expansion expansion;
+
+/** True if a node is a merge key entry (`<<: *name`). */
+static bool is_merge(const ryml::Tree& tree, ryml::id_type id)
+{
+    return tree.has_key(id) && !(tree.type(id).type & ryml::KEYQUO) && tree.key(id) == "<<";
+}
+
+static Target find_anchor(const ryml::Tree& tree, ryml::csubstr name)
+{
+    // the most recent definition takes precedence
+    for (auto it = expansion.anchors.rbegin(); it != expansion.anchors.rend(); ++it) {
+        if (it->name == name) {
+            return it->target;
+        }
+    }
+    raise(tree, "anchor not found");
+}
+
+/**
+ * Resolves all aliases to the nodes they refer to, in a single walk in document order.
+ * @returns True if the tree has any aliases or merge keys.
+ */
+static bool resolve_aliases(const ryml::Tree& tree)
+{
+    expansion.anchors.clear();
+    expansion.key_targets.assign(tree.capacity(), Target());
+    expansion.val_targets.assign(tree.capacity(), Target());
+
+    bool found = false;
+    ryml::id_type id = tree.root_id();
+    while (true) {
+        if (tree.is_key_ref(id)) {
+            expansion.key_targets[id] = find_anchor(tree, tree.keysc(id).anchor);
+            found = true;
+        }
+        if (tree.is_val_ref(id)) {
+            expansion.val_targets[id] = find_anchor(tree, tree.valsc(id).anchor);
+            found = true;
+        }
+        if (is_merge(tree, id)) {
+            found = true;
+        }
+        if (tree.has_key_anchor(id)) {
+            expansion.anchors.push_back({ tree.keysc(id).anchor, { id, true } });
+        }
+        if (tree.has_val_anchor(id)) {
+            expansion.anchors.push_back({ tree.valsc(id).anchor, { id, false } });
+        }
+
+        ryml::id_type child = tree.first_child(id);
+        if (child != ryml::NONE) {
+            id = child;
+            continue;
+        }
+        while (tree.next_sibling(id) == ryml::NONE) {
+            id = tree.parent(id);
+            if (id == ryml::NONE) {
+                return found;
+            }
+        }
+        id = tree.next_sibling(id);
+    }
+}
+
+/** Returns the map to merge from, given the value of a merge key or an item of a sequence in that value. */
+static ryml::id_type merge_source(const ryml::Tree& tree, ryml::id_type id)
+{
+    ryml::id_type source = id;
+    if (tree.is_val_ref(id)) {
+        const Target& target = expansion.val_targets[id];
+        if (target.key) {
+            raise(tree, "merge key must refer to a map");
+        }
+        source = target.id;
+    }
+    if (!tree.is_map(source)) {
+        raise(tree, "merge key must refer to a map");
+    }
+    return source;
+}
+
+/**
+ * Pushes the maps that the merge keys of a map refer to onto the stack of maps to merge from, such that the map
+ * listed first is on top.
+ */
+static void push_merge_sources(const ryml::Tree& tree, ryml::id_type map)
+{
+    std::size_t begin = expansion.sources.size();
+    for (ryml::id_type child = tree.first_child(map); child != ryml::NONE; child = tree.next_sibling(child)) {
+        if (!is_merge(tree, child)) {
+            continue;
+        }
+        if (tree.is_seq(child)) {
+            for (ryml::id_type item = tree.first_child(child); item != ryml::NONE; item = tree.next_sibling(item)) {
+                expansion.sources.push_back(merge_source(tree, item));
+            }
+        } else {
+            expansion.sources.push_back(merge_source(tree, child));
+        }
+    }
+    std::reverse(expansion.sources.begin() + static_cast<std::ptrdiff_t>(begin), expansion.sources.end());
+}
+
+/**
+ * Appends the children of a container to the list of items to write.
+ *
+ * Merge key entries of a map are replaced with the entries of the maps they refer to. Entries of the map itself take
+ * precedence over merged entries, and maps listed earlier take precedence over maps listed later, including the maps
+ * they merge from themselves (i.e. maps to merge from are visited depth-first, in the order they are listed).
+ */
+static void add_items(const ryml::Tree& tree, ryml::id_type content, bool expanded)
+{
+    std::size_t begin = expansion.items.size();
+    bool has_merge = false;
+    for (ryml::id_type child = tree.first_child(content); child != ryml::NONE; child = tree.next_sibling(child)) {
+        if (tree.is_map(content) && is_merge(tree, child)) {
+            has_merge = true;
+        } else {
+            expansion.items.push_back({ child, expanded });
+        }
+    }
+    if (!has_merge) {
+        return;
+    }
+
+    // keys are looked up in a hash set, such that merging many entries takes linear time
+    expansion.keys.clear();
+    for (std::size_t k = begin; k < expansion.items.size(); ++k) {
+        ryml::csubstr key = tree.key(expansion.items[k].id);
+        expansion.keys.insert(std::string_view(key.str, key.len));
+    }
+
+    // an explicit stack rather than recursion, such that a long chain of merges does not exhaust the (small) Wasm stack
+    expansion.sources.clear();
+    expansion.merged.clear();
+    expansion.merged.insert(content);
+    push_merge_sources(tree, content);
+    while (!expansion.sources.empty()) {
+        ryml::id_type source = expansion.sources.back();
+        expansion.sources.pop_back();
+
+        // skip maps already merged from, which also breaks cycles
+        if (!expansion.merged.insert(source).second) {
+            continue;
+        }
+        for (ryml::id_type child = tree.first_child(source); child != ryml::NONE; child = tree.next_sibling(child)) {
+            if (!is_merge(tree, child)) {
+                ryml::csubstr key = tree.key(child);
+                if (expansion.keys.insert(std::string_view(key.str, key.len)).second) {
+                    expansion.items.push_back({ child, true });
+                }
+            }
+        }
+        push_merge_sources(tree, source);
+    }
+}
+
+/** Walks a subtree in document order, with aliases and merge keys replaced by what they refer to. */
+static void walk_expanded(const ryml::Tree& tree, ryml::id_type node, const json::Writer& writer, const json::EmitOptions& options)
+{
+    std::vector<Item>& items = expansion.items;
+    std::vector<Frame>& frames = expansion.frames;
+    items.clear();
+    frames.clear();
+
+    // the subtree root is the single item of a pseudo-container without brackets
+    std::size_t start = writer.size(writer.data);
+    std::size_t expanded_bytes = 0;
+    items.push_back({ node, false });
+    frames.push_back({ ryml::NONE, 0, 0, 1 });
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        if (frame.next == frame.end) {
+            if (frame.content != ryml::NONE) {
+                writer.write_close(writer.data, tree, frame.content);
+            }
+            items.resize(frame.begin);
+            frames.pop_back();
+            continue;
+        }
+        if (frame.next != frame.begin) {
+            writer.write_separator(writer.data);
+        }
+        Item item = items[frame.next++];
+        if (frames.size() - 1 > options.max_depth) {
+            raise(tree, "max depth exceeded");
+        }
+
+        std::size_t before = writer.size(writer.data);
+        ryml::id_type id = item.id;
+        if (frames.size() > 1 && tree.has_key(id)) {
+            if (tree.is_key_ref(id)) {
+                const Target& target = expansion.key_targets[id];
+                if (!target.key && tree.is_container(target.id)) {
+                    raise(tree, "alias of a container used as a key");
+                }
+                writer.write_key(writer.data, tree, target.id, target.key);
+            } else {
+                writer.write_key(writer.data, tree, id, true);
+            }
+        }
+        if (!item.expanded) {
+            // the key of an alias is not part of the expansion
+            before = writer.size(writer.data);
+        }
+
+        bool expanded = item.expanded;
+        ryml::id_type content = id;
+        if (tree.is_val_ref(id)) {
+            const Target& target = expansion.val_targets[id];
+            expanded = true;
+            if (target.key || !tree.is_container(target.id)) {
+                writer.write_scalar(writer.data, tree, target.id, target.key);
+                content = ryml::NONE;
+            } else {
+                content = target.id;
+            }
+        }
+        if (content != ryml::NONE) {
+            if (tree.is_container(content)) {
+                std::size_t begin = items.size();
+                add_items(tree, content, expanded);
+                writer.write_open(writer.data, tree, content, items.size() - begin);
+                frames.push_back({ content, begin, begin, items.size() });
+            } else {
+                writer.write_scalar(writer.data, tree, content, false);
+            }
+        }
+
+        std::size_t size = writer.size(writer.data);
+        if (expanded) {
+            expanded_bytes += size - before;
+            if (expanded_bytes > options.max_expansion_bytes) {
+                raise(tree, "max expansion bytes exceeded");
+            }
+        }
+        if (size - start > options.max_output_bytes) {
+            raise(tree, "max output bytes exceeded");
+        }
+    }
+    if (writer.size(writer.data) - start > options.max_output_bytes) {
+        raise(tree, "max output bytes exceeded");
+    }
+}
+
+bool json::expand(const ryml::Tree& tree, ryml::id_type node, const Writer& writer, const EmitOptions& options)
+{
+    if (!resolve_aliases(tree)) {
+        return false;
+    }
+    walk_expanded(tree, node, writer, options);
+    return true;
+}
+
+static void write_expanded_key(void* data, const ryml::Tree& tree, ryml::id_type id, bool key)
+{
+    std::string& out = *static_cast<std::string*>(data);
+    if (key) {
+        write_key(out, tree, id);
+    } else {
+        write_val(out, tree, id);
+    }
+    out.append(": ", 2);
+}
+
+static void write_expanded_scalar(void* data, const ryml::Tree& tree, ryml::id_type id, bool key)
+{
+    std::string& out = *static_cast<std::string*>(data);
+    if (key) {
+        write_key(out, tree, id);
+    } else {
+        write_val(out, tree, id);
+    }
+}
+
+static void write_expanded_open(void* data, const ryml::Tree& tree, ryml::id_type id, std::size_t)
+{
+    std::string& out = *static_cast<std::string*>(data);
+    if (tree.is_seq(id)) {
+        out.push_back('[');
+    } else if (tree.is_map(id)) {
+        out.push_back('{');
+    }
+}
+
+static void write_expanded_close(void* data, const ryml::Tree& tree, ryml::id_type id)
+{
+    write_close(*static_cast<std::string*>(data), tree, id);
+}
+
+static void write_expanded_separator(void* data)
+{
+    static_cast<std::string*>(data)->push_back(',');
+}
+
+static std::size_t expanded_size(void* data)
+{
+    return static_cast<std::string*>(data)->size();
+}
+
+void json::emit(const ryml::Tree& tree, std::string& out, const EmitOptions& options)
+{
+    if (tree.empty()) {
+        return;
+    }
+    ryml::id_type root = tree.root_id();
+    if (tree.is_stream(root)) {
+        raise(tree, "JSON does not have streams");
+    }
+
+    emit(tree, root, out, options);
+}
+
+void json::emit(const ryml::Tree& tree, ryml::id_type node, std::string& out, const EmitOptions& options)
+{
+    json::Writer writer = { &write_expanded_key, &write_expanded_scalar, &write_expanded_open, &write_expanded_close, &write_expanded_separator, &expanded_size, &out };
+    if (!(options.expand_aliases && expand(tree, node, writer, options))) {
+        emit_tree(tree, node, out, options);
+    }
+}
@@ -0,0 +1,128 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#pragma once
+#include "ryml_all.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace json
+{
+    /** Default maximum nesting depth of output (same as `ryml::EmitOptions::max_depth_default`). */
+    constexpr ryml::id_type default_max_depth = 64;
+
+    /** Settings of `emit`. */
+    struct EmitOptions
+    {
+        /** Maximum nesting depth. */
+        ryml::id_type max_depth = default_max_depth;
+        /** Maximum length of output in bytes. */
+        std::size_t max_output_bytes = SIZE_MAX;
+        /** Whether aliases (`*name`) and merge keys (`<<`) are replaced with the content of the anchored node. */
+        bool expand_aliases = false;
+        /** Maximum number of bytes written on behalf of aliases and merge keys. */
+        std::size_t max_expansion_bytes = 1 << 20;
+    };
+
+    /** The JSON value type a plain YAML scalar maps to. */
+    enum class ScalarKind : unsigned char
+    {
+        string,
+        number,
+        boolean,
+        null
+    };
+
+    /**
+     * Classifies a plain scalar in a single pass.
+     *
+     * Only the literals `true`, `false` and `null`, and numbers that conform to the JSON grammar (e.g. no leading
+     * zeros, `+` signs or bare decimal points) are written unquoted; everything else becomes a JSON string.
+     */
+    ScalarKind classify(const char* str, std::size_t len);
+
+    /** True if a string starts (after optional whitespace) with `{` or `[`, and may be JSON. */
+    bool looks_like_json(const char* str, std::size_t len);
+
+    /**
+     * Validates JSON text and appends it to a buffer with insignificant whitespace removed.
+     *
+     * Output follows the layout of `emit`; strings and numbers are copied verbatim.
+     * @returns False if the input violates the JSON grammar, is nested deeper than `max_depth`, or has more than
+     * `max_values` values (counting each object and array, and each value in them).
+     */
+    bool minify(const char* str, std::size_t len, std::string& out, ryml::id_type max_depth = default_max_depth, ryml::id_type max_values = ryml::NONE);
+
+    /**
+     * Finds the first character that must be escaped in a JSON string.
+     * @returns Pointer to the first quotation mark, backslash or control character, or `end` if there is none.
+     */
+    const char* find_escape(const char* begin, const char* end);
+
+    /**
+     * Appends a double-quoted JSON string to a buffer.
+     *
+     * Quotation marks, backslashes and all control characters (U+0000 to U+001F) are escaped.
+     */
+    void write_string(std::string& out, const char* str, std::size_t len);
+
+    /** Appends the key of a map entry (as a double-quoted JSON string) followed by `: ` to a buffer. */
+    void write_member_key(std::string& out, const ryml::Tree& tree, ryml::id_type node);
+
+    /**
+     * Appends the JSON representation of a YAML tree to a buffer.
+     *
+     * Output follows the layout of `ryml::emitrs_json` except that all control characters are properly escaped,
+     * and plain scalars that are not valid JSON numbers (e.g. `.5` or `+1`) are written as strings.
+     * The tree is walked iteratively, such that nesting depth is bounded by `max_depth` rather than by stack size.
+     *
+     * With `expand_aliases`, an alias is written as the content of the anchored node, which is visited again rather
+     * than copied, and the entries of maps referenced by a merge key are written in place of the merge key (unless
+     * the map has an entry with the same key). Every byte written this way counts towards `max_expansion_bytes`,
+     * which stops exponential blow-up (e.g. "billion laughs") early. Otherwise, aliases are written as strings.
+     *
+     * Errors (e.g. a YAML stream with multiple documents, or exceeding a budget in `options`) are reported through
+     * the error callback of the tree.
+     */
+    void emit(const ryml::Tree& tree, std::string& out, const EmitOptions& options = EmitOptions());
+
+    /**
+     * Appends the JSON representation of a node of a YAML tree (without its key) to a buffer.
+     *
+     * Same as `emit` on a whole tree, except that anchors outside of the subtree are visible to aliases inside it.
+     */
+    void emit(const ryml::Tree& tree, ryml::id_type node, std::string& out, const EmitOptions& options = EmitOptions());
+
+    /**
+     * Functions that write the parts of a tree in some output format, called by `expand` in document order.
+     *
+     * A key or scalar is given as the node whose key (if `key` is true) or value holds the text, which is a node an
+     * alias refers to in place of the alias. A container is opened with its number of items, merged entries included.
+     */
+    struct Writer
+    {
+        void (*write_key)(void* data, const ryml::Tree& tree, ryml::id_type id, bool key);
+        void (*write_scalar)(void* data, const ryml::Tree& tree, ryml::id_type id, bool key);
+        void (*write_open)(void* data, const ryml::Tree& tree, ryml::id_type id, std::size_t count);
+        void (*write_close)(void* data, const ryml::Tree& tree, ryml::id_type id);
+        void (*write_separator)(void* data);
+        /** Number of bytes written so far, which budgets in `EmitOptions` are checked against. */
+        std::size_t (*size)(void* data);
+        void* data;
+    };
+
+    /**
+     * Walks a node of a YAML tree (without its key) with aliases and merge keys replaced by what they refer to, as
+     * `emit` does with `expand_aliases`, and passes its parts to a writer.
+     *
+     * Errors are reported through the error callback of the tree.
+     * @returns False (without writing anything) if the tree has no aliases or merge keys.
+     */
+    bool expand(const ryml::Tree& tree, ryml::id_type node, const Writer& writer, const EmitOptions& options);
+}
@@ -0,0 +1,237 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#include <node_api.h>
+#include "string.hpp"
+#include "yaml.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+// Node.js addon (N-API), which calls the same conversion functions as the Wasm build, and exports functions with the
+// same signature as `dist/yaml_to_json_array.js` and `dist/check_yaml.js`
+
+extern "C"
+{
+    String* transform_yaml(String* in_str);
+    String* transform_yaml_or_error(String* in_str);
+}
+
+/** Tag of a result of `transform_yaml_or_error` that holds an error message. */
+constexpr char tag_error = 'E';
+
+/** Number of threads in the libuv thread pool unless set with `UV_THREADPOOL_SIZE`. */
+constexpr std::size_t default_thread_pool_size = 4;
+
+/** Copies the content of a `Uint8Array` (e.g. a `Buffer`) into a string, or returns null (with a pending exception). */
+static String* to_string(napi_env env, napi_value value)
+{
+    bool is_typed_array = false;
+    napi_typedarray_type type;
+    std::size_t length;
+    void* data;
+    if (napi_is_typedarray(env, value, &is_typed_array) != napi_ok || !is_typed_array
+        || napi_get_typedarray_info(env, value, &type, &length, &data, nullptr, nullptr) != napi_ok || type != napi_uint8_array) {
+        napi_throw_type_error(env, nullptr, "expected a Uint8Array");
+        return nullptr;
+    }
+    return new String(static_cast<const char*>(data), length);
+}
+
+/** Turns a string into a `Buffer` (or `null` if there is no string), and releases the string. */
+static napi_value to_buffer(napi_env env, String* str)
+{
+    napi_value result;
+    if (!str) {
+        napi_get_null(env, &result);
+        return result;
+    }
+    if (napi_create_buffer_copy(env, str->size(), str->data(), nullptr, &result) != napi_ok) {
+        result = nullptr;
+    }
+    delete str;
+    return result;
+}
+
+/** Returns the single argument of a function call. */
+static napi_value argument(napi_env env, napi_callback_info info)
+{
+    std::size_t argc = 1;
+    napi_value argv[1] = { nullptr };
+    napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr);
+    if (argc < 1) {
+        napi_throw_type_error(env, nullptr, "expected an argument");
+        return nullptr;
+    }
+    return argv[0];
+}
+
+/** Converts a YAML string into a JSON string, or `null` if the YAML string is malformed. */
+static napi_value yaml_to_json(napi_env env, napi_callback_info info)
+{
+    napi_value arg = argument(env, info);
+    String* in_str = arg ? to_string(env, arg) : nullptr;
+    if (!in_str) {
+        return nullptr;
+    }
+    String* result = transform_yaml(in_str);
+    delete in_str;
+    return to_buffer(env, result);
+}
+
+/** Checks a YAML string, and returns an error message, or `null` if the YAML string is valid. */
+static napi_value check_yaml(napi_env env, napi_callback_info info)
+{
+    napi_value arg = argument(env, info);
+    String* in_str = arg ? to_string(env, arg) : nullptr;
+    if (!in_str) {
+        return nullptr;
+    }
+    String* result = transform_yaml_or_error(in_str);
+    delete in_str;
+
+    String* message = nullptr;
+    if ((*result)[0] == tag_error) {
+        message = new String(result->data() + 1, result->size() - 1);
+    }
+    delete result;
+    return to_buffer(env, message);
+}
+
+/** A batch of YAML strings converted on threads of the libuv thread pool. */
+struct Batch
+{
+    std::vector<String*> inputs;
+    std::vector<String*> results;
+    /** Index of the next input not yet taken by a thread. */
+    std::atomic<std::size_t> next{ 0 };
+    std::vector<napi_async_work> works;
+    /** Number of works not yet complete. */
+    std::size_t pending = 0;
+    napi_deferred deferred = nullptr;
+
+    ~Batch()
+    {
+        for (String* input : inputs) {
+            delete input;
+        }
+        for (String* result : results) {
+            delete result;
+        }
+    }
+};
+
+/** Converts inputs of a batch until none is left (runs on a thread of the pool, with parser state of its own). */
+static void execute_batch(napi_env env, void* data)
+{
+    Batch* batch = static_cast<Batch*>(data);
+    std::size_t count = batch->inputs.size();
+    for (std::size_t i = batch->next++; i < count; i = batch->next++) {
+        batch->results[i] = transform_yaml(batch->inputs[i]);
+    }
+}
+
+/** Resolves the promise of a batch once all of its works are complete (runs on the main thread). */
+static void complete_batch(napi_env env, napi_status status, void* data)
+{
+    Batch* batch = static_cast<Batch*>(data);
+    if (--batch->pending > 0) {
+        return;
+    }
+    for (napi_async_work work : batch->works) {
+        napi_delete_async_work(env, work);
+    }
+
+    napi_value array;
+    napi_create_array_with_length(env, batch->results.size(), &array);
+    for (std::size_t i = 0; i < batch->results.size(); ++i) {
+        napi_set_element(env, array, static_cast<std::uint32_t>(i), to_buffer(env, batch->results[i]));
+        batch->results[i] = nullptr;
+    }
+    napi_resolve_deferred(env, batch->deferred, array);
+    delete batch;
+}
+
+/** Converts an array of YAML strings in parallel, and returns a promise of an array of JSON strings (or `null`). */
+static napi_value yaml_to_json_batch(napi_env env, napi_callback_info info)
+{
+    napi_value arg = argument(env, info);
+    if (!arg) {
+        return nullptr;
+    }
+    bool is_array = false;
+    napi_is_array(env, arg, &is_array);
+    if (!is_array) {
+        napi_throw_type_error(env, nullptr, "expected an array of Uint8Array");
+        return nullptr;
+    }
+
+    // copy inputs on the main thread, because conversion modifies strings in place
+    std::uint32_t count = 0;
+    napi_get_array_length(env, arg, &count);
+    Batch* batch = new Batch();
+    batch->inputs.resize(count, nullptr);
+    batch->results.resize(count, nullptr);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        napi_value item;
+        napi_get_element(env, arg, i, &item);
+        batch->inputs[i] = to_string(env, item);
+        if (!batch->inputs[i]) {
+            delete batch;
+            return nullptr;
+        }
+    }
+
+    napi_value promise;
+    napi_create_promise(env, &batch->deferred, &promise);
+    if (count == 0) {
+        napi_value array;
+        napi_create_array(env, &array);
+        napi_resolve_deferred(env, batch->deferred, array);
+        delete batch;
+        return promise;
+    }
+
+    // queue as many works as there are threads in the pool, each of which takes inputs until none is left
+    std::size_t threads = default_thread_pool_size;
+    if (const char* size = std::getenv("UV_THREADPOOL_SIZE")) {
+        threads = std::max(1L, std::strtol(size, nullptr, 10));
+    }
+    threads = std::min<std::size_t>(threads, count);
+
+    napi_value name;
+    napi_create_string_utf8(env, "yamlToJsonBatch", NAPI_AUTO_LENGTH, &name);
+    batch->works.resize(threads);
+    batch->pending = threads;
+    for (napi_async_work& work : batch->works) {
+        napi_create_async_work(env, nullptr, name, &execute_batch, &complete_batch, batch, &work);
+    }
+    for (napi_async_work work : batch->works) {
+        napi_queue_async_work(env, work);
+    }
+    return promise;
+}
+
+static napi_value init(napi_env env, napi_value exports)
+{
+    yaml::initialize();
+
+    napi_property_descriptor properties[] = {
+        { "yamlToJson", nullptr, &yaml_to_json, nullptr, nullptr, nullptr, napi_enumerable, nullptr },
+        { "checkYaml", nullptr, &check_yaml, nullptr, nullptr, nullptr, napi_enumerable, nullptr },
+        { "yamlToJsonBatch", nullptr, &yaml_to_json_batch, nullptr, nullptr, nullptr, napi_enumerable, nullptr },
+        // names of the Wasm build
+        { "yaml_to_json_array", nullptr, &yaml_to_json, nullptr, nullptr, nullptr, napi_enumerable, nullptr },
+        { "check_yaml", nullptr, &check_yaml, nullptr, nullptr, nullptr, napi_enumerable, nullptr }
+    };
+    napi_define_properties(env, exports, sizeof(properties) / sizeof(properties[0]), properties);
+    return exports;
+}
+
+NAPI_MODULE(yaml_to_json, init)
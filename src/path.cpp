@@ -0,0 +1,85 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#include "path.hpp"
+#include <cstring>
+
+bool path::parse(const char* str, std::size_t len, std::vector<Segment>& segments)
+{
+    segments.clear();
+    const char* p = str;
+    const char* end = str + len;
+    while (p != end) {
+        if (*p == '[') {
+            ++p;
+            if (p != end && *p == '"') {
+                // quoted key, e.g. `["a.b"]`
+                ++p;
+                const char* quote = static_cast<const char*>(std::memchr(p, '"', end - p));
+                if (!quote || quote + 1 == end || quote[1] != ']') {
+                    return false;
+                }
+                segments.push_back({ ryml::csubstr(p, quote - p), 0, false });
+                p = quote + 2;
+            } else {
+                // index, e.g. `[0]`
+                const char* digits = p;
+                std::size_t index = 0;
+                for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+                    index = 10 * index + (*p - '0');
+                    if (index >= ryml::NONE) {
+                        return false;
+                    }
+                }
+                if (p == digits || p == end || *p != ']') {
+                    return false;
+                }
+                ++p;
+                segments.push_back({ ryml::csubstr(), index, true });
+            }
+        } else {
+            // plain key, which follows a `.` unless at the start of the path
+            if (p != str) {
+                if (*p != '.') {
+                    return false;
+                }
+                ++p;
+            }
+            const char* key = p;
+            while (p != end && *p != '.' && *p != '[') {
+                ++p;
+            }
+            if (p == key) {
+                return false;
+            }
+            segments.push_back({ ryml::csubstr(key, p - key), 0, false });
+        }
+    }
+    return true;
+}
+
+bool path::matches(const ryml::Tree& tree, ryml::id_type node, std::size_t position, const Segment& segment)
+{
+    if (segment.is_index) {
+        return position == segment.index;
+    } else {
+        return tree.has_key(node) && tree.key(node) == segment.key;
+    }
+}
+
+ryml::id_type path::find(const ryml::Tree& tree, ryml::id_type node, const Segment* begin, const Segment* end)
+{
+    for (const Segment* segment = begin; segment != end && node != ryml::NONE; ++segment) {
+        if (segment->is_index) {
+            node = tree.is_seq(node) ? tree.child(node, static_cast<ryml::id_type>(segment->index)) : ryml::NONE;
+        } else {
+            node = tree.is_map(node) ? tree.find_child(node, segment->key) : ryml::NONE;
+        }
+    }
+    return node;
+}
@@ -0,0 +1,45 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#pragma once
+#include "ryml_all.hpp"
+#include <cstddef>
+#include <vector>
+
+/**
+ * Paths that address a node in a YAML tree.
+ *
+ * A path is a sequence of keys separated by `.`, and indexes in square brackets, e.g. `a.b[0].c`. A key in square
+ * brackets and double quotes (e.g. `["a.b"]`) may contain any character except `"`. The empty path refers to the root.
+ * Paths follow keys and items as they are written in the YAML document; aliases and merge keys are not followed.
+ */
+namespace path
+{
+    /** A step of a path: the key of a map entry, or the index of a sequence item. */
+    struct Segment
+    {
+        ryml::csubstr key;
+        std::size_t index;
+        bool is_index;
+    };
+
+    /**
+     * Splits a path into segments, which refer to the characters of the path.
+     * @returns False if the path is malformed.
+     */
+    bool parse(const char* str, std::size_t len, std::vector<Segment>& segments);
+
+    /** True if a node is the entry or item that a segment refers to, given its position among its siblings. */
+    bool matches(const ryml::Tree& tree, ryml::id_type node, std::size_t position, const Segment& segment);
+
+    /**
+     * Follows a sequence of segments from a node.
+     * @returns The node the segments lead to, or `NONE` if there is no such node.
+     */
+    ryml::id_type find(const ryml::Tree& tree, ryml::id_type node, const Segment* begin, const Segment* end);
+}
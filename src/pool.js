@@ -0,0 +1,210 @@
+/**
+ * Converts YAML to JSON on several cores in Node.js with the Wasm build, for hosts that do not allow native addons.
+ *
+ * Wasm code is compiled once into a `WebAssembly.Module` on the main thread, and shared with a number of
+ * `worker_threads`, each of which creates an instance of its own. A batch of rows is split into chunks, and each chunk
+ * is packed into a single `ArrayBuffer` that is transferred (rather than copied) to an idle worker, and back with the
+ * results.
+ */
+
+const fs = require("fs");
+const os = require("os");
+const path = require("path");
+const { Worker, isMainThread, parentPort, workerData } = require("worker_threads");
+const { create_instance, acquire_instance } = require("./instance.js");
+
+/** Length of a row that stands for `null` in a packed buffer. */
+const NULL_LENGTH = 0xFFFFFFFF;
+
+/** Maximum number of bytes of YAML input in a chunk sent to a worker. */
+const CHUNK_BYTES = 1 << 20;
+
+/**
+ * Returns a function that runs Emscripten output with a module object and a `WebAssembly` namespace.
+ *
+ * @param {string} artifact Path to the Emscripten output, e.g. `dist/yaml_to_json_array.js`.
+ * @returns {function(Object, Object)} Function to pass to `create_instance`.
+ */
+function load_setup(artifact) {
+    const emscripten_output = fs.readFileSync(artifact, "utf8");
+    const run = new Function("Module", "WebAssembly", "require", "__dirname", emscripten_output);
+    return (Module, WebAssembly) => run(Module, WebAssembly, require, path.dirname(artifact));
+}
+
+/**
+ * Packs rows into a buffer, each row prefixed with its length as a 32-bit integer.
+ *
+ * @param {Array<Uint8Array | null>} rows Rows to pack.
+ * @returns {ArrayBuffer} Packed rows.
+ */
+function pack(rows) {
+    const size = rows.reduce((total, row) => total + 4 + (row ? row.length : 0), 4);
+    const buffer = new ArrayBuffer(size);
+    const view = new DataView(buffer);
+    const bytes = new Uint8Array(buffer);
+    view.setUint32(0, rows.length, true);
+    let offset = 4;
+    for (const row of rows) {
+        view.setUint32(offset, row ? row.length : NULL_LENGTH, true);
+        offset += 4;
+        if (row) {
+            bytes.set(row, offset);
+            offset += row.length;
+        }
+    }
+    return buffer;
+}
+
+/**
+ * Unpacks rows from a buffer produced by `pack`, as views of the buffer.
+ *
+ * @param {ArrayBuffer} buffer Packed rows.
+ * @returns {Array<Uint8Array | null>} Rows.
+ */
+function unpack(buffer) {
+    const view = new DataView(buffer);
+    const count = view.getUint32(0, true);
+    const rows = new Array(count);
+    let offset = 4;
+    for (let i = 0; i < count; ++i) {
+        const length = view.getUint32(offset, true);
+        offset += 4;
+        if (length === NULL_LENGTH) {
+            rows[i] = null;
+        } else {
+            rows[i] = new Uint8Array(buffer, offset, length);
+            offset += length;
+        }
+    }
+    return rows;
+}
+
+/**
+ * A pool of worker threads that convert YAML to JSON with the Wasm build.
+ */
+class YamlPool {
+    /**
+     * Compiles Wasm code, and starts worker threads.
+     *
+     * @param {number} [workers] Number of worker threads (one per core by default).
+     * @param {string} [artifact] Path to the Emscripten output `dist/yaml_to_json_array.js`.
+     */
+    constructor(workers = os.cpus().length, artifact = path.join(__dirname, "..", "dist", "yaml_to_json_array.js")) {
+        // compile once on the main thread, and share the compiled module with workers
+        const compiled = create_instance(load_setup(artifact)).recycler.compiled;
+
+        this.tasks = [];
+        this.idle = [];
+        this.workers = [];
+        for (let k = 0; k < Math.max(1, workers); ++k) {
+            const worker = new Worker(__filename, { workerData: { artifact: artifact, compiled: compiled } });
+            worker.on("message", buffer => this.finish(worker, null, buffer));
+            worker.on("error", error => this.finish(worker, error, null));
+            this.workers.push(worker);
+            this.idle.push(worker);
+        }
+    }
+
+    /**
+     * Converts a batch of YAML strings to JSON strings.
+     *
+     * @param {Uint8Array[]} rows The YAML strings to convert.
+     * @returns {Promise<Array<Uint8Array | null>>} The JSON strings, or `null` for rows that fail to convert, in the
+     * order of the input; rejected if a worker stops with an error, or if no workers are left.
+     */
+    async convert(rows) {
+        // split into chunks of about the same size, such that workers share the load
+        const chunks = [];
+        let start = 0;
+        let bytes = 0;
+        for (let i = 0; i < rows.length; ++i) {
+            bytes += rows[i] ? rows[i].length : 0;
+            if (bytes >= CHUNK_BYTES || i + 1 === rows.length) {
+                chunks.push(rows.slice(start, i + 1));
+                start = i + 1;
+                bytes = 0;
+            }
+        }
+
+        const results = await Promise.all(chunks.map(chunk => new Promise((resolve, reject) => {
+            if (this.workers.length === 0) {
+                // all workers have stopped (or the pool is closed), and no worker would ever take the task
+                reject(new Error("no worker threads"));
+                return;
+            }
+            this.tasks.push({ buffer: pack(chunk), resolve: resolve, reject: reject });
+            this.dispatch();
+        })));
+        return [].concat(...results);
+    }
+
+    /**
+     * Sends tasks to idle workers.
+     */
+    dispatch() {
+        while (this.tasks.length > 0 && this.idle.length > 0) {
+            const worker = this.idle.pop();
+            worker.task = this.tasks.shift();
+            worker.postMessage(worker.task.buffer, [worker.task.buffer]);
+        }
+    }
+
+    /**
+     * Completes the task of a worker.
+     *
+     * @param {Worker} worker The worker that has completed its task.
+     * @param {Error | null} error The error the worker has raised, if any.
+     * @param {ArrayBuffer | null} buffer Packed results.
+     */
+    finish(worker, error, buffer) {
+        const task = worker.task;
+        worker.task = null;
+        if (error) {
+            // a worker that has raised an error has stopped
+            this.workers = this.workers.filter(w => w !== worker);
+            this.idle = this.idle.filter(w => w !== worker);
+            if (task) {
+                task.reject(error);
+            }
+            if (this.workers.length === 0) {
+                this.tasks.splice(0).forEach(t => t.reject(error));
+            }
+            return;
+        }
+        this.idle.push(worker);
+        task.resolve(unpack(buffer));
+        this.dispatch();
+    }
+
+    /**
+     * Stops all worker threads.
+     *
+     * @returns {Promise} Resolves when all workers have stopped.
+     */
+    close() {
+        const workers = this.workers;
+        this.workers = [];
+        this.idle = [];
+        return Promise.all(workers.map(worker => worker.terminate()));
+    }
+}
+
+if (!isMainThread) {
+    // instances of a worker are created from the compiled module shared by the main thread, and recycled as in UDFs
+    const setup = load_setup(workerData.artifact);
+    let instance = create_instance(setup, { recycler: { compiled: workerData.compiled, rows: 0, resets: -1 } });
+    parentPort.on("message", buffer => {
+        const results = pack(unpack(buffer).map(row => {
+            if (!row) {
+                return null;
+            }
+            instance = acquire_instance(setup, instance);
+            return instance.yaml_to_json_array(row);
+        }));
+        parentPort.postMessage(results, [results]);
+    });
+}
+
+if (typeof module != "undefined") {
+    module["exports"] = { "YamlPool": YamlPool, "pack": pack, "unpack": unpack };
+}
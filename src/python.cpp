@@ -0,0 +1,187 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "string.hpp"
+#include "yaml.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// CPython extension module `yaml_to_json`, which calls the same conversion functions as the Wasm build
+
+extern "C"
+{
+    String* transform_yaml(String* in_str);
+    String* transform_yaml_or_error(String* in_str);
+}
+
+/** Tag of a result of `transform_yaml_or_error` that holds an error message. */
+constexpr char tag_error = 'E';
+
+/** Copies the content of a bytes-like object into a string, or returns null (with a Python exception set). */
+static String* to_string(PyObject* obj)
+{
+    Py_buffer view;
+    if (PyObject_GetBuffer(obj, &view, PyBUF_SIMPLE) < 0) {
+        return nullptr;
+    }
+    String* str = new String(static_cast<const char*>(view.buf), static_cast<std::size_t>(view.len));
+    PyBuffer_Release(&view);
+    return str;
+}
+
+/** Turns a conversion result into `bytes` (or `None` for a failed conversion), and releases the result. */
+static PyObject* to_bytes(String* result)
+{
+    if (!result) {
+        Py_RETURN_NONE;
+    }
+    PyObject* obj = PyBytes_FromStringAndSize(result->data(), static_cast<Py_ssize_t>(result->size()));
+    delete result;
+    return obj;
+}
+
+static PyObject* yaml_to_json(PyObject* self, PyObject* arg)
+{
+    String* in_str = to_string(arg);
+    if (!in_str) {
+        return nullptr;
+    }
+
+    String* result;
+    Py_BEGIN_ALLOW_THREADS
+    result = transform_yaml(in_str);
+    Py_END_ALLOW_THREADS
+    delete in_str;
+    return to_bytes(result);
+}
+
+static PyObject* check_yaml(PyObject* self, PyObject* arg)
+{
+    String* in_str = to_string(arg);
+    if (!in_str) {
+        return nullptr;
+    }
+
+    String* result;
+    Py_BEGIN_ALLOW_THREADS
+    result = transform_yaml_or_error(in_str);
+    Py_END_ALLOW_THREADS
+    delete in_str;
+
+    PyObject* obj;
+    if ((*result)[0] == tag_error) {
+        obj = PyUnicode_DecodeUTF8(result->data() + 1, static_cast<Py_ssize_t>(result->size() - 1), "replace");
+    } else {
+        Py_INCREF(Py_None);
+        obj = Py_None;
+    }
+    delete result;
+    return obj;
+}
+
+static PyObject* yaml_to_json_many(PyObject* self, PyObject* args, PyObject* kwargs)
+{
+    static const char* keywords[] = { "items", "threads", nullptr };
+    PyObject* items;
+    int threads = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|i", const_cast<char**>(keywords), &items, &threads)) {
+        return nullptr;
+    }
+
+    PyObject* sequence = PySequence_Fast(items, "expected a sequence of bytes-like objects");
+    if (!sequence) {
+        return nullptr;
+    }
+
+    // copy inputs while holding the GIL, because conversion modifies strings in place
+    std::size_t count = static_cast<std::size_t>(PySequence_Fast_GET_SIZE(sequence));
+    std::vector<String*> inputs(count, nullptr);
+    for (std::size_t i = 0; i < count; ++i) {
+        inputs[i] = to_string(PySequence_Fast_GET_ITEM(sequence, i));
+        if (!inputs[i]) {
+            for (String* input : inputs) {
+                delete input;
+            }
+            Py_DECREF(sequence);
+            return nullptr;
+        }
+    }
+    Py_DECREF(sequence);
+
+    std::size_t workers = threads > 0 ? static_cast<std::size_t>(threads) : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min(workers, count);
+
+    // each thread converts the next item not yet taken, with parser state of its own
+    std::vector<String*> results(count, nullptr);
+    std::atomic<std::size_t> next(0);
+    auto convert = [&]() {
+        for (std::size_t i = next++; i < count; i = next++) {
+            results[i] = transform_yaml(inputs[i]);
+        }
+    };
+
+    Py_BEGIN_ALLOW_THREADS
+    std::vector<std::thread> pool;
+    for (std::size_t k = 1; k < workers; ++k) {
+        pool.emplace_back(convert);
+    }
+    convert();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    Py_END_ALLOW_THREADS
+
+    for (String* input : inputs) {
+        delete input;
+    }
+
+    PyObject* list = PyList_New(static_cast<Py_ssize_t>(count));
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!list) {
+            delete results[i];
+            continue;
+        }
+        PyObject* obj = to_bytes(results[i]);
+        if (!obj) {
+            Py_CLEAR(list);
+            continue;
+        }
+        PyList_SET_ITEM(list, static_cast<Py_ssize_t>(i), obj);
+    }
+    return list;
+}
+
+static PyMethodDef methods[] = {
+    { "yaml_to_json", yaml_to_json, METH_O, "Converts a YAML string encoded in UTF-8 to a JSON string encoded in UTF-8, or returns None if the YAML string is malformed." },
+    { "check_yaml", check_yaml, METH_O, "Checks whether a YAML string encoded in UTF-8 represents a valid YAML document, and returns None, or an error message." },
+    { "yaml_to_json_many", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(yaml_to_json_many)), METH_VARARGS | METH_KEYWORDS, "Converts a list of YAML strings encoded in UTF-8 in parallel on a number of threads (all cores by default) without holding the GIL, and returns a list of JSON strings (None for malformed YAML strings) in the same order." },
+    { nullptr, nullptr, 0, nullptr }
+};
+
+static PyModuleDef module = {
+    PyModuleDef_HEAD_INIT,
+    "yaml_to_json",
+    "Converts YAML to JSON with Rapid YAML.\n\n"
+    "Parser state is kept per thread, such that yaml_to_json_many converts items on threads of its own. Settings of the "
+    "conversion functions (e.g. limits) are shared by all threads without synchronization, and must not be changed "
+    "(e.g. with transform_configure by a native host that loads the same library) while a batch is converted. The "
+    "result cache is kept per thread: its capacity applies to the thread that sets it only, and worker threads of "
+    "yaml_to_json_many convert without a cache.",
+    -1,
+    methods
+};
+
+PyMODINIT_FUNC PyInit_yaml_to_json(void)
+{
+    yaml::initialize();
+    return PyModule_Create(&module);
+}
@@ -0,0 +1,276 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#include "schema.hpp"
+#include "cache.hpp"
+#include "document.hpp"
+#include "json.hpp"
+#include <cstdio>
+
+/** Names of JSON value types, in the order of `DocumentType`. */
+static const char* const type_names[] = { "null", "boolean", "number", "string", "array", "object" };
+
+/** Initial number of buckets of the hash table (a power of two). */
+constexpr std::size_t initial_buckets = 64;
+
+static std::uint64_t hash_edge(std::uint32_t parent, ryml::csubstr key, bool is_item)
+{
+    std::uint64_t h = is_item ? 0 : hash_bytes(key.str, key.len);
+    return h ^ ((static_cast<std::uint64_t>(parent) + 1) * UINT64_C(0x9e3779b97f4a7c15));
+}
+
+Schema::Schema()
+    : _buckets(initial_buckets, 0)
+{
+    // the root path
+    _nodes.push_back(Node{ none, 0, 0, false, {} });
+}
+
+std::uint32_t Schema::child(std::uint32_t parent, ryml::csubstr key, bool is_item)
+{
+    std::size_t mask = _buckets.size() - 1;
+    for (std::size_t i = hash_edge(parent, key, is_item) & mask;; i = (i + 1) & mask) {
+        std::uint32_t bucket = _buckets[i];
+        if (!bucket) {
+            if (_nodes.size() >= max_paths) {
+                return none;
+            }
+
+            std::uint32_t id = static_cast<std::uint32_t>(_nodes.size());
+            _nodes.push_back(Node{ parent, static_cast<std::uint32_t>(_keys.size()), static_cast<std::uint32_t>(key.len), is_item, {} });
+            _keys.append(key.str, key.len);
+            _buckets[i] = id + 1;
+
+            // keep the load factor at or below one half
+            if (2 * _nodes.size() > _buckets.size()) {
+                rehash();
+            }
+            return id;
+        }
+
+        const Node& node = _nodes[bucket - 1];
+        if (node.parent == parent && node.is_item == is_item && node.key_length == key.len && _keys.compare(node.key_offset, node.key_length, key.str, key.len) == 0) {
+            return bucket - 1;
+        }
+    }
+}
+
+void Schema::rehash()
+{
+    _buckets.assign(2 * _buckets.size(), 0);
+    std::size_t mask = _buckets.size() - 1;
+
+    // the root path is not reachable through the hash table
+    for (std::size_t id = 1; id < _nodes.size(); ++id) {
+        const Node& node = _nodes[id];
+        ryml::csubstr key(_keys.data() + node.key_offset, node.key_length);
+        std::size_t i = hash_edge(node.parent, key, node.is_item) & mask;
+        while (_buckets[i]) {
+            i = (i + 1) & mask;
+        }
+        _buckets[i] = static_cast<std::uint32_t>(id + 1);
+    }
+}
+
+void Schema::count(std::uint32_t node, int type, std::size_t length)
+{
+    Stats& stats = _nodes[node].stats[type - 1];
+    ++stats.count;
+    if (length > stats.max_length) {
+        stats.max_length = length;
+    }
+}
+
+void Schema::record(const ryml::Tree& tree)
+{
+    ++_rows;
+    ryml::id_type id = tree.root_id();
+    _trail.clear();
+    _trail.push_back(0);
+
+    // walk the tree in document order, with the path of each node at the top of the trail
+    while (true) {
+        std::uint32_t node = _trail.back();
+        ryml::id_type first = ryml::NONE;
+        if (node != none) {
+            int type = static_cast<int>(document_type(tree, id));
+            if (tree.is_container(id)) {
+                count(node, type, tree.num_children(id));
+                first = tree.first_child(id);
+            } else {
+                count(node, type, type != static_cast<int>(DocumentType::null) ? tree.val(id).len : 0);
+            }
+        } else {
+            ++_dropped;
+        }
+
+        if (first != ryml::NONE) {
+            id = first;
+            _trail.push_back(child(node, tree.has_key(id) ? tree.key(id) : ryml::csubstr(), tree.is_seq(tree.parent(id))));
+            continue;
+        }
+
+        // move to the next sibling, or to the next sibling of the closest ancestor that has one
+        while (true) {
+            _trail.pop_back();
+            if (_trail.empty()) {
+                return;
+            }
+            ryml::id_type sibling = tree.next_sibling(id);
+            if (sibling != ryml::NONE) {
+                id = sibling;
+                _trail.push_back(child(_trail.back(), tree.has_key(id) ? tree.key(id) : ryml::csubstr(), tree.is_seq(tree.parent(id))));
+                break;
+            }
+            id = tree.parent(id);
+        }
+    }
+}
+
+namespace
+{
+    /** Arguments of a function that parses a YAML string and records its schema. */
+    struct SchemaRecording
+    {
+        Schema* schema;
+        char* str;
+        const yaml::Options* options;
+        bool is_stream;
+    };
+}
+
+static void parse_and_record(void* data)
+{
+    SchemaRecording* args = static_cast<SchemaRecording*>(data);
+    const ryml::Tree& tree = yaml::parse(args->str, *args->options);
+    if (tree.is_stream(tree.root_id())) {
+        // a stream of multiple documents has no JSON representation
+        args->is_stream = true;
+        return;
+    }
+    args->schema->record(tree);
+}
+
+bool Schema::add(char* str, const yaml::Options& options)
+{
+    SchemaRecording args = { this, str, &options, false };
+    if (!yaml::guard(&parse_and_record, &args) || args.is_stream) {
+        ++_errors;
+        return false;
+    }
+    return true;
+}
+
+void Schema::merge(const Schema& other)
+{
+    // parents precede children, so paths of the other schema are mapped in order
+    std::size_t size = other._nodes.size();
+    std::vector<std::uint32_t> mapping(size, none);
+    mapping[0] = 0;
+    for (std::size_t id = 0; id < size; ++id) {
+        const Node& node = other._nodes[id];
+        if (id > 0 && mapping[node.parent] != none) {
+            ryml::csubstr key(other._keys.data() + node.key_offset, node.key_length);
+            mapping[id] = child(mapping[node.parent], key, node.is_item);
+        }
+
+        Stats* stats = mapping[id] != none ? _nodes[mapping[id]].stats : nullptr;
+        for (std::size_t type = 0; type < type_count; ++type) {
+            const Stats& source = other._nodes[id].stats[type];
+            if (!stats) {
+                _dropped += source.count;
+            } else {
+                stats[type].count += source.count;
+                if (source.max_length > stats[type].max_length) {
+                    stats[type].max_length = source.max_length;
+                }
+            }
+        }
+    }
+
+    _rows += other._rows;
+    _errors += other._errors;
+    _dropped += other._dropped;
+}
+
+static void write_number(std::string& out, std::size_t value)
+{
+    char buffer[24];
+    int count = std::snprintf(buffer, sizeof(buffer), "%zu", value);
+    out.append(buffer, count);
+}
+
+/** True if a key can be written in a path without quotes (see `path::parse`). */
+static bool is_plain_key(const char* str, std::size_t len)
+{
+    if (!len) {
+        return false;
+    }
+    for (std::size_t i = 0; i < len; ++i) {
+        if (str[i] == '.' || str[i] == '[' || str[i] == ']' || str[i] == '"') {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Schema::write(std::string& out) const
+{
+    out += "{\"rows\":";
+    write_number(out, _rows);
+    out += ",\"errors\":";
+    write_number(out, _errors);
+    out += ",\"dropped\":";
+    write_number(out, _dropped);
+    out += ",\"paths\":[";
+
+    // parents precede children, so each path extends one that has been built before
+    std::vector<std::string> paths(_nodes.size());
+    bool first = true;
+    for (std::size_t id = 0; id < _nodes.size(); ++id) {
+        const Node& node = _nodes[id];
+        if (id > 0) {
+            std::string& path = paths[id];
+            path = paths[node.parent];
+            const char* key = _keys.data() + node.key_offset;
+            if (node.is_item) {
+                path += "[]";
+            } else if (is_plain_key(key, node.key_length)) {
+                if (!path.empty()) {
+                    path += '.';
+                }
+                path.append(key, node.key_length);
+            } else {
+                path += "[\"";
+                path.append(key, node.key_length);
+                path += "\"]";
+            }
+        }
+
+        for (std::size_t type = 0; type < type_count; ++type) {
+            const Stats& stats = node.stats[type];
+            if (!stats.count) {
+                continue;
+            }
+            if (!first) {
+                out += ',';
+            }
+            first = false;
+            out += '[';
+            json::write_string(out, paths[id].data(), paths[id].size());
+            out += ",\"";
+            out += type_names[type];
+            out += "\",";
+            write_number(out, stats.count);
+            out += ',';
+            write_number(out, stats.max_length);
+            out += ']';
+        }
+    }
+    out += "]}";
+}
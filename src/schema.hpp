@@ -0,0 +1,101 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#pragma once
+#include "ryml_all.hpp"
+#include "yaml.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Aggregates the structure of many YAML documents without converting them to JSON.
+ *
+ * For each path (e.g. `a.b[].c`, where `[]` stands for any item of a sequence), the schema records how many times
+ * each JSON value type has been seen, and the maximum length of those values: the number of bytes of a scalar, or the
+ * number of items (or entries) of an array (or object).
+ *
+ * Paths are kept in a trie whose edges are looked up in a single open-addressing hash table keyed by parent and key.
+ * At most `max_paths` distinct paths are recorded; values at further paths are only counted as dropped.
+ */
+class Schema
+{
+public:
+    /** Maximum number of distinct paths recorded. */
+    static constexpr std::size_t max_paths = 1 << 16;
+
+    Schema();
+
+    /**
+     * Parses a YAML string in place, and records the paths and value types of the document.
+     * @returns False if the YAML string is malformed, exceeds a budget in `options`, or is a stream of documents.
+     */
+    bool add(char* str, const yaml::Options& options);
+
+    /** Adds the counts of another schema (e.g. of another partition) to this schema. */
+    void merge(const Schema& other);
+
+    /**
+     * Appends the aggregate as a JSON object to a buffer.
+     *
+     * The object has the fields `rows` (documents added), `errors` (documents that could not be parsed), `dropped`
+     * (values at paths beyond `max_paths`) and `paths`, an array of `[path, type, count, max_length]` entries in the
+     * order paths have been first seen.
+     */
+    void write(std::string& out) const;
+
+    /** Records the paths and value types of a parsed document. */
+    void record(const ryml::Tree& tree);
+
+private:
+    /** Number of JSON value types (see `DocumentType`). */
+    static constexpr std::size_t type_count = 6;
+
+    /** Sentinel for a path that has not been recorded. */
+    static constexpr std::uint32_t none = UINT32_MAX;
+
+    struct Stats
+    {
+        std::size_t count = 0;
+        std::size_t max_length = 0;
+    };
+
+    /** A path, identified by its parent path and the key (or any item) that follows it. */
+    struct Node
+    {
+        std::uint32_t parent;
+        /** Position of the key in the key pool. */
+        std::uint32_t key_offset;
+        std::uint32_t key_length;
+        /** True if the path continues with any item of a sequence (and has no key). */
+        bool is_item;
+        Stats stats[type_count];
+    };
+
+    /** Looks up (or adds) the path that continues a parent path, or returns `none` if the schema is full. */
+    std::uint32_t child(std::uint32_t parent, ryml::csubstr key, bool is_item);
+
+    /** Counts a value seen at a path. */
+    void count(std::uint32_t node, int type, std::size_t length);
+
+    /** Doubles the number of buckets of the hash table, and re-inserts all paths. */
+    void rehash();
+
+    std::vector<Node> _nodes;
+    /** Keys of all paths, back to back. */
+    std::string _keys;
+    /** Open-addressing hash table of paths, holding an index into `_nodes` plus one (zero for an empty bucket). */
+    std::vector<std::uint32_t> _buckets;
+    /** Paths from the root to the node being walked, reused across documents. */
+    std::vector<std::uint32_t> _trail;
+
+    std::size_t _rows = 0;
+    std::size_t _errors = 0;
+    std::size_t _dropped = 0;
+};
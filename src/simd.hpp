@@ -0,0 +1,71 @@
+/**
+ * Portable 128-bit SIMD primitives for byte scanning
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#pragma once
+#include <cstdint>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define SIMD_WIDTH 16
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_WIDTH 16
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SIMD_WIDTH 16
+#else
+#define SIMD_WIDTH 0
+#endif
+
+#if SIMD_WIDTH > 0
+namespace simd
+{
+#if defined(__wasm_simd128__)
+    using bytes = v128_t;
+
+    /** Loads 16 bytes from (potentially unaligned) memory. */
+    inline bytes load(const char* p) { return wasm_v128_load(p); }
+    /** Broadcasts a single byte value to all lanes. */
+    inline bytes splat(std::uint8_t c) { return wasm_i8x16_splat(static_cast<char>(c)); }
+    /** Lanes equal to each other. */
+    inline bytes eq(bytes a, bytes b) { return wasm_i8x16_eq(a, b); }
+    /** Lanes less than or equal to each other, treating bytes as unsigned. */
+    inline bytes le(bytes a, bytes b) { return wasm_u8x16_le(a, b); }
+    inline bytes bit_or(bytes a, bytes b) { return wasm_v128_or(a, b); }
+    /** Collects the most significant bit of each lane into an integer. */
+    inline std::uint32_t bitmask(bytes a) { return wasm_i8x16_bitmask(a); }
+#elif defined(__SSE2__)
+    using bytes = __m128i;
+
+    inline bytes load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    inline bytes splat(std::uint8_t c) { return _mm_set1_epi8(static_cast<char>(c)); }
+    inline bytes eq(bytes a, bytes b) { return _mm_cmpeq_epi8(a, b); }
+    inline bytes le(bytes a, bytes b) { return _mm_cmpeq_epi8(_mm_min_epu8(a, b), a); }
+    inline bytes bit_or(bytes a, bytes b) { return _mm_or_si128(a, b); }
+    inline std::uint32_t bitmask(bytes a) { return static_cast<std::uint32_t>(_mm_movemask_epi8(a)); }
+#elif defined(__ARM_NEON)
+    using bytes = uint8x16_t;
+
+    inline bytes load(const char* p) { return vld1q_u8(reinterpret_cast<const std::uint8_t*>(p)); }
+    inline bytes splat(std::uint8_t c) { return vdupq_n_u8(c); }
+    inline bytes eq(bytes a, bytes b) { return vceqq_u8(a, b); }
+    inline bytes le(bytes a, bytes b) { return vcleq_u8(a, b); }
+    inline bytes bit_or(bytes a, bytes b) { return vorrq_u8(a, b); }
+    inline std::uint32_t bitmask(bytes a)
+    {
+        // NEON has no movemask instruction; weigh each lane by its bit position and sum horizontally
+        static const std::uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+        uint8x16_t m = vandq_u8(a, vld1q_u8(weights));
+        return static_cast<std::uint32_t>(vaddv_u8(vget_low_u8(m))) | (static_cast<std::uint32_t>(vaddv_u8(vget_high_u8(m))) << 8);
+    }
+#endif
+
+    /** Index of the lowest set bit in a non-zero mask. */
+    inline unsigned first_set(std::uint32_t mask) { return static_cast<unsigned>(__builtin_ctz(mask)); }
+}
+#endif
@@ -0,0 +1,478 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#include "split.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+/** True if a character ends the indicator of a block sequence item, or a plain token. */
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/** True if a line holds white space only. */
+static bool is_blank_line(const char* p, const char* end)
+{
+    for (; p != end; ++p) {
+        if (!is_space(*p)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** True if the header of a block scalar (`|` or `>` with optional indicators) starts at a position of a line. */
+static bool is_block_header(const char* p, const char* end)
+{
+    ++p;
+    while (p != end && ((*p >= '0' && *p <= '9') || *p == '+' || *p == '-')) {
+        ++p;
+    }
+    if (p != end && !is_space(*p)) {
+        return false;
+    }
+    while (p != end && is_space(*p)) {
+        ++p;
+    }
+    return p == end || *p == '#';
+}
+
+namespace
+{
+    /** Tracks the context that spans lines while scanning a document line by line. */
+    struct Scanner
+    {
+        bool in_single = false;
+        bool in_double = false;
+        std::size_t flow_depth = 0;
+        bool in_block_scalar = false;
+
+        /** True if a line at column 0 would be inside a scalar or collection that has started on a previous line. */
+        bool in_multiline() const
+        {
+            return in_single || in_double || flow_depth > 0;
+        }
+
+        /**
+         * Scans a line (or its rest after an item indicator) for quotes, flow collections, comments and block scalar
+         * headers.
+         * @returns False if the line holds an alias that `aliases` forbids.
+         */
+        bool scan(const char* p, const char* end, bool aliases)
+        {
+            char prev = ' ';
+            for (; p != end; prev = *p++) {
+                char c = *p;
+                if (in_double) {
+                    if (c == '\\' && p + 1 != end) {
+                        ++p;
+                    } else if (c == '"') {
+                        in_double = false;
+                    }
+                    continue;
+                }
+                if (in_single) {
+                    if (c == '\'') {
+                        if (p + 1 != end && p[1] == '\'') {
+                            ++p;
+                        } else {
+                            in_single = false;
+                        }
+                    }
+                    continue;
+                }
+
+                // a token starts after white space or a flow indicator (or, in flow context, a value indicator)
+                bool token_start = prev == ' ' || prev == '\t' || prev == '[' || prev == '{' || prev == ',' || (flow_depth > 0 && prev == ':');
+                switch (c) {
+                case '#':
+                    if (prev == ' ' || prev == '\t') {
+                        return true;
+                    }
+                    break;
+                case '"':
+                    in_double = in_double || token_start;
+                    break;
+                case '\'':
+                    in_single = in_single || token_start;
+                    break;
+                case '[':
+                case '{':
+                    if (token_start || flow_depth > 0) {
+                        ++flow_depth;
+                    }
+                    break;
+                case ']':
+                case '}':
+                    if (flow_depth > 0) {
+                        --flow_depth;
+                    }
+                    break;
+                case '*':
+                    if (token_start && aliases) {
+                        return false;
+                    }
+                    break;
+                case '|':
+                case '>':
+                    if (token_start && flow_depth == 0 && is_block_header(p, end)) {
+                        in_block_scalar = true;
+                        return true;
+                    }
+                    break;
+                }
+            }
+            return true;
+        }
+    };
+}
+
+bool split::find_items(const char* str, std::size_t len, bool aliases, std::vector<std::size_t>& items)
+{
+    items.clear();
+    Scanner scanner;
+    const char* end = str + len;
+    for (const char* line = str; line != end; ) {
+        const char* eol = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        const char* line_end = eol ? eol : end;
+        const char* next = eol ? eol + 1 : end;
+
+        if (scanner.in_block_scalar) {
+            // content of a block scalar is indented, and the first line at column 0 ends it
+            if (is_blank_line(line, line_end) || *line == ' ' || *line == '\t') {
+                line = next;
+                continue;
+            }
+            scanner.in_block_scalar = false;
+        }
+
+        if (is_blank_line(line, line_end) || *line == ' ' || *line == '\t') {
+            // an indented line continues the current item
+            if (!scanner.scan(line, line_end, aliases)) {
+                return false;
+            }
+        } else if (scanner.in_multiline()) {
+            return false;
+        } else if (*line == '#') {
+            // a comment line
+        } else if (*line == '-' && (line + 1 == line_end || is_space(line[1]))) {
+            items.push_back(static_cast<std::size_t>(line - str));
+            if (!scanner.scan(line + 1, line_end, aliases)) {
+                return false;
+            }
+        } else {
+            // a map, a scalar, a directive or a document marker
+            return false;
+        }
+        line = next;
+    }
+    return !items.empty() && !scanner.in_multiline();
+}
+
+namespace
+{
+    /** A run of consecutive items of a top-level sequence, converted on its own. */
+    struct Chunk
+    {
+        char* str = nullptr;
+        std::string json = {};
+        ryml::id_type nodes = 0;
+        bool success = false;
+    };
+
+    /** Arguments of a function that parses a chunk, and emits the JSON array of its items. */
+    struct ChunkConversion
+    {
+        Chunk* chunk;
+        char* str;
+        const yaml::Options* options;
+    };
+}
+
+static void parse_and_emit_chunk(void* data)
+{
+    ChunkConversion* args = static_cast<ChunkConversion*>(data);
+    const ryml::Tree& tree = yaml::parse(args->str, *args->options);
+    args->chunk->nodes = tree.size();
+    json::emit(tree, args->chunk->json, args->options->emit);
+}
+
+/**
+ * Converts a chunk with the parser state of the calling thread.
+ *
+ * A copy of the chunk is parsed in place, such that the document remains intact to be converted again on the calling
+ * thread if the chunk fails to convert.
+ */
+static void convert_chunk(Chunk& chunk, const yaml::Options& options)
+{
+    std::string copy(chunk.str);
+    ChunkConversion args = { &chunk, copy.data(), &options };
+    chunk.success = yaml::guard(&parse_and_emit_chunk, &args) && chunk.json.size() >= 2 && chunk.json.front() == '[' && chunk.json.back() == ']';
+}
+
+namespace
+{
+    /** A run of consecutive children of a container, written into a buffer of its own. */
+    struct Run
+    {
+        ryml::id_type first = ryml::NONE;
+        /** The child after the last child of the run (or `NONE`). */
+        ryml::id_type end = ryml::NONE;
+        std::string json = {};
+        bool success = false;
+        std::string error = {};
+    };
+
+    /** Arguments of a function that writes the children of a run. */
+    struct RunEmission
+    {
+        const ryml::Tree* tree;
+        Run* run;
+        const json::EmitOptions* options;
+    };
+
+    /** Arguments of a function that writes an entire tree. */
+    struct TreeEmission
+    {
+        const ryml::Tree* tree;
+        std::string* json;
+        const json::EmitOptions* options;
+    };
+}
+
+static void emit_run(void* data)
+{
+    RunEmission* args = static_cast<RunEmission*>(data);
+    const ryml::Tree& tree = *args->tree;
+    Run& run = *args->run;
+    for (ryml::id_type child = run.first; child != run.end; child = tree.next_sibling(child)) {
+        if (child != run.first) {
+            run.json.push_back(',');
+        }
+        // the key of a subtree root belongs to its parent
+        if (tree.has_key(child)) {
+            json::write_member_key(run.json, tree, child);
+        }
+        json::emit(tree, child, run.json, *args->options);
+    }
+}
+
+static void emit_tree(void* data)
+{
+    TreeEmission* args = static_cast<TreeEmission*>(data);
+    json::emit(*args->tree, *args->json, *args->options);
+}
+
+/** Message of the error that writing a tree on the calling thread raises when output exceeds its budget. */
+constexpr const char* output_budget_error = "max output bytes exceeded in YAML at line 0 column 0 offset 0";
+
+/** Writes an entire tree on the calling thread. */
+static bool emit_serial(const ryml::Tree& tree, std::string& json, const json::EmitOptions& options)
+{
+    TreeEmission args = { &tree, &json, &options };
+    return yaml::guard(&emit_tree, &args);
+}
+
+bool split::emit(const ryml::Tree& tree, std::string& json, const json::EmitOptions& options, std::size_t threads)
+{
+    if (threads < 2 || options.expand_aliases || tree.empty() || tree.size() < min_parallel_nodes || tree.is_stream(tree.root_id())) {
+        return emit_serial(tree, json, options);
+    }
+
+    // descend to the first container with more than one child, whose ancestors are written on the calling thread
+    std::vector<ryml::id_type> ancestors;
+    ryml::id_type node = tree.root_id();
+    while (tree.is_container(node) && tree.num_children(node) == 1 && tree.is_container(tree.first_child(node))) {
+        ancestors.push_back(node);
+        node = tree.first_child(node);
+    }
+    std::size_t depth = ancestors.size();
+    if (!tree.is_container(node) || tree.num_children(node) < 2 || depth + 1 > options.max_depth) {
+        return emit_serial(tree, json, options);
+    }
+
+    // size children by the span of their node identifiers, and group them into runs of about the same size
+    std::vector<ryml::id_type> children;
+    std::vector<std::size_t> spans;
+    std::size_t total = 0;
+    for (ryml::id_type child = tree.first_child(node); child != ryml::NONE; child = tree.next_sibling(child)) {
+        ryml::id_type next = tree.next_sibling(child);
+        ryml::id_type bound = next != ryml::NONE ? next : tree.size();
+        std::size_t span = bound > child ? bound - child : 1;
+        children.push_back(child);
+        spans.push_back(span);
+        total += span;
+    }
+    std::size_t run_count = std::min(4 * threads, children.size());
+    std::vector<Run> runs;
+    std::size_t accumulated = 0;
+    for (std::size_t i = 0; i < children.size(); ++i) {
+        if (runs.empty() || accumulated >= total * runs.size() / run_count) {
+            if (!runs.empty()) {
+                runs.back().end = children[i];
+            }
+            runs.push_back({ children[i] });
+        }
+        accumulated += spans[i];
+    }
+
+    // children are written at a depth below the container, and each run observes the output budget on its own
+    json::EmitOptions run_options = options;
+    run_options.max_depth = options.max_depth - static_cast<ryml::id_type>(depth + 1);
+    std::atomic<std::size_t> next(0);
+    auto write = [&]() {
+        for (std::size_t k = next++; k < runs.size(); k = next++) {
+            RunEmission args = { &tree, &runs[k], &run_options };
+            runs[k].success = yaml::guard(&emit_run, &args);
+            if (!runs[k].success) {
+                runs[k].error = yaml::error_message();
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t k = 1; k < std::min(threads, runs.size()); ++k) {
+        pool.emplace_back(write);
+    }
+    write();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    // report the error that a serial walk would run into first
+    std::size_t size = 2 * (depth + 1) + runs.size() - 1;
+    for (const Run& run : runs) {
+        if (!run.success) {
+            yaml::set_error_message(run.error);
+            return false;
+        }
+        size += run.json.size();
+        if (size > options.max_output_bytes) {
+            yaml::set_error_message(output_budget_error);
+            return false;
+        }
+    }
+
+    // open ancestors and the container, join runs, and close them again
+    std::size_t start = json.size();
+    json.reserve(start + size);
+    ancestors.push_back(node);
+    for (std::size_t i = 0; i < ancestors.size(); ++i) {
+        ryml::id_type id = ancestors[i];
+        if (i > 0 && tree.has_key(id)) {
+            json::write_member_key(json, tree, id);
+        }
+        json.push_back(tree.is_seq(id) ? '[' : '{');
+    }
+    for (std::size_t k = 0; k < runs.size(); ++k) {
+        if (k > 0) {
+            json.push_back(',');
+        }
+        json += runs[k].json;
+        std::string().swap(runs[k].json);
+    }
+    for (std::size_t i = ancestors.size(); i-- > 0; ) {
+        json.push_back(tree.is_seq(ancestors[i]) ? ']' : '}');
+    }
+    if (json.size() - start > options.max_output_bytes) {
+        yaml::set_error_message(output_budget_error);
+        return false;
+    }
+    return true;
+}
+
+bool split::to_json(char* str, std::string& json, const yaml::Options& options, std::size_t threads)
+{
+    std::size_t len = std::strlen(str);
+    if (threads < 2 || len < min_document_bytes || len > options.max_input_bytes) {
+        return yaml::to_json(str, json, options);
+    }
+    std::vector<std::size_t> items;
+    if (!find_items(str, len, options.emit.expand_aliases, items)) {
+        // parse on the calling thread, and write in parallel
+        ryml::Tree tree;
+        return yaml::to_tree(str, tree, options) && emit(tree, json, options.emit, threads);
+    }
+
+    // chunks of about the same size (several per thread, such that threads share the load), which start at an item
+    std::size_t chunk_count = std::min(4 * threads, len / min_chunk_bytes);
+    std::vector<Chunk> chunks;
+    chunks.push_back({ str });
+    for (std::size_t k = 1, i = 0; k < chunk_count; ++k) {
+        std::size_t target = len * k / chunk_count;
+        while (i < items.size() && (items[i] < target || items[i] == 0)) {
+            ++i;
+        }
+        if (i == items.size()) {
+            break;
+        }
+        if (str + items[i] != chunks.back().str) {
+            chunks.push_back({ str + items[i] });
+        }
+    }
+    if (chunks.size() < 2) {
+        ryml::Tree tree;
+        return yaml::to_tree(str, tree, options) && emit(tree, json, options.emit, threads);
+    }
+
+    // terminate each chunk at the line break before the next one
+    for (std::size_t k = 1; k < chunks.size(); ++k) {
+        chunks[k].str[-1] = '\0';
+    }
+
+    // each thread converts the next chunk not yet taken, with parser state of its own
+    std::atomic<std::size_t> next(0);
+    auto convert = [&]() {
+        for (std::size_t k = next++; k < chunks.size(); k = next++) {
+            convert_chunk(chunks[k], options);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t k = 1; k < std::min(threads, chunks.size()); ++k) {
+        pool.emplace_back(convert);
+    }
+    convert();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    // a single sequence node stands for the roots of all chunks
+    std::size_t nodes = 1;
+    std::size_t size = 0;
+    bool success = true;
+    for (const Chunk& chunk : chunks) {
+        if (!chunk.success) {
+            success = false;
+            break;
+        }
+        nodes += chunk.nodes - 1;
+        size += chunk.json.size() - 1;
+    }
+    if (!success || nodes > options.max_nodes || size + 1 > options.emit.max_output_bytes) {
+        // convert the document as a whole, such that the error (and its location) is the same as without chunks
+        for (std::size_t k = 1; k < chunks.size(); ++k) {
+            chunks[k].str[-1] = '\n';
+        }
+        return yaml::to_json(str, json, options);
+    }
+
+    // join arrays of items, replacing the closing bracket of one array and the opening bracket of the next with a comma
+    json.reserve(json.size() + size + 1);
+    json.push_back('[');
+    for (std::size_t k = 0; k < chunks.size(); ++k) {
+        if (k > 0) {
+            json.push_back(',');
+        }
+        json.append(chunks[k].json, 1, chunks[k].json.size() - 2);
+        std::string().swap(chunks[k].json);
+    }
+    json.push_back(']');
+    return true;
+}
@@ -0,0 +1,71 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#pragma once
+#include "yaml.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Parallel conversion of a document that is a large top-level block sequence (`- ` items at column 0).
+ *
+ * The items of such a document are independent of each other (unless aliases are expanded), such that the document
+ * can be split into chunks of consecutive items, which are parsed into trees of their own on separate threads, and
+ * whose JSON arrays are joined in order. Large trees of other documents are written in parallel subtree by subtree.
+ */
+namespace split
+{
+    /** Documents shorter than this number of bytes are converted on the calling thread. */
+    constexpr std::size_t min_document_bytes = 4 << 20;
+
+    /** Chunks are at least this number of bytes long. */
+    constexpr std::size_t min_chunk_bytes = 1 << 20;
+
+    /** Trees with fewer nodes than this are written on the calling thread. */
+    constexpr std::size_t min_parallel_nodes = 1 << 18;
+
+    /**
+     * Finds the offsets at which top-level sequence items start.
+     *
+     * A line is the start of an item if it starts with `-` followed by white space, and it is not inside a block
+     * scalar, a quoted scalar or a flow collection. Only a leading comment may precede the first item.
+     * @returns False if the document is not a top-level block sequence, or if a split would be ambiguous (e.g. a
+     * quoted scalar or flow collection spans a line at column 0, or an alias refers to an anchor that might be in
+     * another chunk when `aliases` is true, or the document has directives or document markers).
+     */
+    bool find_items(const char* str, std::size_t len, bool aliases, std::vector<std::size_t>& items);
+
+    /**
+     * Appends the JSON representation of a YAML tree to a buffer, writing subtrees of a large tree on a number of
+     * threads.
+     *
+     * The container whose children are written in parallel is the root, or the first descendant of the root that
+     * has more than one child (e.g. the sequence in `{data: [...]}`). Its children are sized by the span of their
+     * node identifiers (nodes are numbered in document order as they are parsed), and runs of consecutive children of
+     * about the same size are written into separate buffers, which are joined with separators. Output is the same as
+     * that of `json::emit`. Small trees, and trees whose aliases are expanded (as an alias may refer to an anchor in
+     * another subtree), are written on the calling thread.
+     * Must not be called from a function passed to `yaml::guard`.
+     * @returns False if the tree exceeds any of the budgets in `options`; see `yaml::error_message`.
+     */
+    bool emit(const ryml::Tree& tree, std::string& json, const json::EmitOptions& options, std::size_t threads);
+
+    /**
+     * Parses a YAML string in place, and appends its JSON representation to a buffer, converting a large top-level
+     * sequence in chunks on a number of threads. Any other large document (or a sequence that cannot be split safely)
+     * is parsed on the calling thread, and written with `emit`.
+     *
+     * Output is the same as that of `yaml::to_json`. Budgets in `options` apply to the document as a whole. Chunks are
+     * parsed from copies, such that a document in which any chunk fails (or which exceeds a budget) is converted again
+     * on the calling thread, and reports the same error (at the same location) as `yaml::to_json`.
+     * @returns False if the YAML string is malformed, or exceeds any of the budgets in `options`; see
+     * `yaml::error_message`.
+     */
+    bool to_json(char* str, std::string& json, const yaml::Options& options, std::size_t threads);
+}
@@ -0,0 +1,169 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#include "tape.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/** Entries and string pool of the tape being written, reused across calls. */
+static thread_local std::vector<std::uint32_t> entries;
+static thread_local std::string pool;
+
+[[noreturn]] static void raise(const ryml::Tree& tree, const char* msg)
+{
+    const ryml::Callbacks& cb = tree.callbacks();
+    cb.m_error(msg, std::strlen(msg), ryml::Location(std::size_t(0), std::size_t(0), std::size_t(0)), cb.m_user_data);
+    std::abort();  // error callback must not return
+}
+
+static void add_entry(const ryml::Tree& tree, tape::Kind kind, std::size_t payload)
+{
+    if (payload > tape::max_payload) {
+        raise(tree, "value too large for tape");
+    }
+    entries.push_back(static_cast<std::uint32_t>(payload) << tape::kind_bits | static_cast<std::uint32_t>(kind));
+}
+
+static void add_text(const ryml::Tree& tree, tape::Kind kind, ryml::csubstr text)
+{
+    add_entry(tree, kind, text.len);
+    pool.append(text.str, text.len);
+}
+
+/** Adds a key or value scalar (with the flags of the other part of the node masked off), mirroring `json::emit`. */
+static void add_scalar(const ryml::Tree& tree, const ryml::NodeScalar& sc, ryml::type_bits flags)
+{
+    if (sc.scalar.len) {
+        json::ScalarKind kind = (flags & (ryml::KEY | ryml::VALQUO)) ? json::ScalarKind::string : json::classify(sc.scalar.str, sc.scalar.len);
+        switch (kind) {
+        case json::ScalarKind::string:
+            add_text(tree, tape::Kind::string, sc.scalar);
+            break;
+        case json::ScalarKind::number:
+            add_text(tree, tape::Kind::number, sc.scalar);
+            break;
+        case json::ScalarKind::boolean:
+            add_entry(tree, sc.scalar.str[0] == 't' ? tape::Kind::boolean_true : tape::Kind::boolean_false, 0);
+            break;
+        case json::ScalarKind::null:
+            add_entry(tree, tape::Kind::null, 0);
+            break;
+        }
+    } else if (sc.scalar.str || (flags & (ryml::KEY | ryml::VALQUO | ryml::KEYTAG | ryml::VALTAG))) {
+        add_entry(tree, tape::Kind::string, 0);
+    } else {
+        add_entry(tree, tape::Kind::null, 0);
+    }
+}
+
+/** Adds the key (if any) and the value of a scalar node, or the key (if any) of a container and its item count. */
+static void add_node(const ryml::Tree& tree, ryml::id_type id)
+{
+    if (tree.has_key(id)) {
+        add_scalar(tree, tree.keysc(id), tree.type(id).type & ~ryml::VAL);
+    }
+    if (tree.is_container(id)) {
+        add_entry(tree, tree.is_map(id) ? tape::Kind::object : tape::Kind::array, tree.num_children(id));
+    } else if (tree.is_val(id) || tree.is_keyval(id)) {
+        add_scalar(tree, tree.valsc(id), tree.type(id).type & ~ryml::KEY);
+    }
+}
+
+/** Size of the tape written so far in bytes. */
+static std::size_t tape_size()
+{
+    return sizeof(std::uint32_t) * (entries.size() + 1) + pool.size();
+}
+
+/** Adds the key (if `key` is true) or the value of a scalar node, as a key or a value of the expanded tree. */
+static void add_expanded_scalar(void*, const ryml::Tree& tree, ryml::id_type id, bool key)
+{
+    if (key) {
+        add_scalar(tree, tree.keysc(id), tree.type(id).type & ~ryml::VAL);
+    } else {
+        add_scalar(tree, tree.valsc(id), tree.type(id).type & ~ryml::KEY);
+    }
+}
+
+static void add_expanded_open(void*, const ryml::Tree& tree, ryml::id_type id, std::size_t count)
+{
+    add_entry(tree, tree.is_map(id) ? tape::Kind::object : tape::Kind::array, count);
+}
+
+static void add_expanded_close(void*, const ryml::Tree&, ryml::id_type)
+{
+}
+
+static void add_expanded_separator(void*)
+{
+}
+
+static std::size_t expanded_tape_size(void*)
+{
+    return tape_size();
+}
+
+/** Appends the entries and the string pool written so far to a buffer. */
+static void write_tape(std::string& out)
+{
+    std::uint32_t count = static_cast<std::uint32_t>(entries.size());
+    out.reserve(out.size() + tape_size());
+    out.append(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.append(reinterpret_cast<const char*>(entries.data()), sizeof(std::uint32_t) * entries.size());
+    out.append(pool);
+}
+
+void tape::emit(const ryml::Tree& tree, std::string& out, const json::EmitOptions& options)
+{
+    entries.clear();
+    pool.clear();
+    if (tree.empty()) {
+        return;
+    }
+    ryml::id_type root = tree.root_id();
+    if (tree.is_stream(root)) {
+        raise(tree, "JSON does not have streams");
+    }
+
+    // aliases and merge keys are replaced by what they refer to, as in `json::emit`
+    static const json::Writer writer = { &add_expanded_scalar, &add_expanded_scalar, &add_expanded_open, &add_expanded_close, &add_expanded_separator, &expanded_tape_size, nullptr };
+    if (options.expand_aliases && json::expand(tree, root, writer, options)) {
+        write_tape(out);
+        return;
+    }
+
+    // walk the tree in document order without recursion, as in `json::emit`
+    ryml::id_type id = root;
+    ryml::id_type depth = 0;
+    while (true) {
+        if (depth > options.max_depth) {
+            raise(tree, "max depth exceeded");
+        }
+        add_node(tree, id);
+        if (tape_size() > options.max_output_bytes) {
+            raise(tree, "max output bytes exceeded");
+        }
+
+        ryml::id_type child = tree.first_child(id);
+        if (child != ryml::NONE) {
+            id = child;
+            ++depth;
+            continue;
+        }
+        while (depth > 0 && tree.next_sibling(id) == ryml::NONE) {
+            id = tree.parent(id);
+            --depth;
+        }
+        if (depth == 0) {
+            break;
+        }
+        id = tree.next_sibling(id);
+    }
+    write_tape(out);
+}
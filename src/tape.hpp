@@ -0,0 +1,56 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#pragma once
+#include "ryml_all.hpp"
+#include "json.hpp"
+#include <cstdint>
+#include <string>
+
+/**
+ * A compact binary representation of a JSON value, which JavaScript turns into native objects without parsing text.
+ *
+ * Layout (words are 32-bit unsigned integers in the byte order of the host, which is little-endian in Wasm):
+ * - word 0: number of entries `n`
+ * - words 1 to `n`: entries in document order
+ * - after the entries: string pool, the concatenated (unescaped) UTF-8 text of all strings and numbers
+ *
+ * The low 3 bits of an entry hold the kind of the value, and the remaining bits a payload. Strings and numbers have
+ * their length in bytes as payload, and take the next unread bytes of the string pool. Arrays have the number of
+ * items, and objects the number of members as payload. An item of an array is a single value (with its own items, if
+ * any), and a member of an object is a string entry (the key) followed by a value.
+ */
+namespace tape
+{
+    /** Kind of a value in a tape entry. */
+    enum class Kind : std::uint32_t
+    {
+        null = 0,
+        boolean_false = 1,
+        boolean_true = 2,
+        number = 3,
+        string = 4,
+        array = 5,
+        object = 6
+    };
+
+    /** Number of low bits in an entry that hold the kind of a value. */
+    constexpr unsigned kind_bits = 3;
+
+    /** Largest length or item count an entry can hold. */
+    constexpr std::uint32_t max_payload = UINT32_MAX >> kind_bits;
+
+    /**
+     * Appends the tape representation of a YAML tree to a buffer.
+     *
+     * Scalars map to values as in `json::emit`. Aliases are kept as strings, or with `expand_aliases`, replaced by what
+     * they refer to (and so are merge keys) as in `json::emit`. Depth, output size and expansion size are checked
+     * against `options`, and errors are reported through the error callback of the tree.
+     */
+    void emit(const ryml::Tree& tree, std::string& out, const json::EmitOptions& options = json::EmitOptions());
+}
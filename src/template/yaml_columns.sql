@@ -0,0 +1,59 @@
+--
+-- Extracts columns from YAML with Wasm.
+--
+-- Copyright 2024, Levente Hunyadi
+-- https://github.com/hunyadi/yaml-to-json
+
+CREATE OR REPLACE FUNCTION
+  YAML_COLUMNS(YAML_ARRAY BINARY, PATHS ARRAY)
+  RETURNS TABLE (
+    C1 VARIANT, C2 VARIANT, C3 VARIANT, C4 VARIANT, C5 VARIANT, C6 VARIANT, C7 VARIANT, C8 VARIANT,
+    C9 VARIANT, C10 VARIANT, C11 VARIANT, C12 VARIANT, C13 VARIANT, C14 VARIANT, C15 VARIANT, C16 VARIANT,
+    C17 VARIANT, C18 VARIANT, C19 VARIANT, C20 VARIANT, C21 VARIANT, C22 VARIANT, C23 VARIANT, C24 VARIANT,
+    C25 VARIANT, C26 VARIANT, C27 VARIANT, C28 VARIANT, C29 VARIANT, C30 VARIANT, C31 VARIANT, C32 VARIANT,
+    C33 VARIANT, C34 VARIANT, C35 VARIANT, C36 VARIANT, C37 VARIANT, C38 VARIANT, C39 VARIANT, C40 VARIANT,
+    C41 VARIANT, C42 VARIANT, C43 VARIANT, C44 VARIANT, C45 VARIANT, C46 VARIANT, C47 VARIANT, C48 VARIANT,
+    C49 VARIANT, C50 VARIANT, C51 VARIANT, C52 VARIANT, C53 VARIANT, C54 VARIANT, C55 VARIANT, C56 VARIANT,
+    C57 VARIANT, C58 VARIANT, C59 VARIANT, C60 VARIANT, C61 VARIANT, C62 VARIANT, C63 VARIANT, C64 VARIANT
+  )
+  LANGUAGE JAVASCRIPT
+  COMMENT = 'Parses a YAML binary string encoded in UTF-8 once, and returns a single row whose column Cn holds the value at the n-th path (e.g. a.b[0].c), for up to 64 paths.'
+AS
+$$
+{
+    initialize: function (argumentInfo, context) {
+@@BASE64_DECODER@@
+
+@@INSTANCE_MANAGER@@
+
+        function setup(Module, WebAssembly) {
+@@EMSCRIPTEN_OUTPUT@@
+        }
+
+        this.setup = setup;
+        this.acquire_instance = acquire_instance;
+    },
+
+    processRow: function (row, rowWriter, context) {
+        if (row.PATHS.length > 64) {
+            throw new Error("YAML_COLUMNS extracts at most 64 paths");
+        }
+        if (!row.YAML_ARRAY) {
+            rowWriter.writeRow({});
+            return;
+        }
+
+        // paths are compiled once per instance, and re-used for as long as they stay the same
+        globalThis.YAML_COLUMNS_MODULE = this.acquire_instance(this.setup, globalThis.YAML_COLUMNS_MODULE);
+        const columns = globalThis.YAML_COLUMNS_MODULE.yaml_to_columns([row.YAML_ARRAY], row.PATHS);
+        if (!columns) {
+            throw new Error("YAML_COLUMNS has received a malformed path");
+        }
+        const result = {};
+        columns.forEach((column, k) => {
+            result["C" + (k + 1)] = column[0] === undefined ? null : column[0];
+        });
+        rowWriter.writeRow(result);
+    }
+}
+$$
@@ -0,0 +1,37 @@
+--
+-- Filters YAML with Wasm.
+--
+-- Copyright 2024, Levente Hunyadi
+-- https://github.com/hunyadi/yaml-to-json
+
+CREATE OR REPLACE FUNCTION
+  YAML_CONTAINS_ARRAY(YAML_ARRAY BINARY, PATH VARCHAR, VALUE VARCHAR)
+  RETURNS BOOLEAN
+  LANGUAGE JAVASCRIPT
+  RETURNS NULL ON NULL INPUT
+  IMMUTABLE
+  COMMENT = 'Checks if the node at a path (e.g. a.b[0].c) of a YAML binary string encoded in UTF-8 is a scalar equal to a value, parsing only as much of the document as necessary.'
+AS
+$$
+@@BASE64_DECODER@@
+
+@@INSTANCE_MANAGER@@
+
+function setup(Module, WebAssembly) {
+@@EMSCRIPTEN_OUTPUT@@
+}
+
+Module = acquire_instance(setup, typeof(Module) === "undefined" ? undefined : Module);
+
+return Module.yaml_contains(YAML_ARRAY, PATH, VALUE);
+$$;
+
+CREATE OR REPLACE FUNCTION
+  YAML_CONTAINS(YAML_STRING VARCHAR, PATH VARCHAR, VALUE VARCHAR)
+  RETURNS BOOLEAN
+  LANGUAGE SQL
+  COMMENT = 'Checks if the node at a path (e.g. a.b[0].c) of a YAML string is a scalar equal to a value, parsing only as much of the document as necessary.'
+AS
+$$
+  YAML_CONTAINS_ARRAY(TO_BINARY(YAML_STRING, 'UTF-8'), PATH, VALUE)
+$$
@@ -0,0 +1,50 @@
+--
+-- Extracts values from YAML with Wasm.
+--
+-- Copyright 2024, Levente Hunyadi
+-- https://github.com/hunyadi/yaml-to-json
+
+CREATE OR REPLACE FUNCTION
+  YAML_EXTRACT(YAML_ARRAY BINARY, PATHS ARRAY)
+  RETURNS OBJECT
+  LANGUAGE JAVASCRIPT
+  RETURNS NULL ON NULL INPUT
+  IMMUTABLE
+  COMMENT = 'Parses a YAML binary string encoded in UTF-8 once, and returns an object that maps each path (e.g. a.b[0].c) to the value found there.'
+AS
+$$
+@@BASE64_DECODER@@
+
+@@INSTANCE_MANAGER@@
+
+function setup(Module, WebAssembly) {
+@@EMSCRIPTEN_OUTPUT@@
+}
+
+Module = acquire_instance(setup, typeof(Module) === "undefined" ? undefined : Module);
+
+const document = Module.yaml_open(YAML_ARRAY);
+if (!document) {
+  return null;
+}
+try {
+  const result = {};
+  for (const path of PATHS) {
+    const value = document.get(path);
+    result[path] = value === undefined ? null : value;
+  }
+  return result;
+} finally {
+  document.close();
+}
+$$;
+
+CREATE OR REPLACE FUNCTION
+  YAML_EXTRACT_PATHS(YAML_STRING VARCHAR, PATHS ARRAY)
+  RETURNS OBJECT
+  LANGUAGE SQL
+  COMMENT = 'Parses a YAML string once, and returns an object that maps each path (e.g. a.b[0].c) to the value found there.'
+AS
+$$
+  YAML_EXTRACT(TO_BINARY(YAML_STRING, 'UTF-8'), PATHS)
+$$
@@ -0,0 +1,49 @@
+--
+-- Infers the structure of YAML documents with Wasm.
+--
+-- Copyright 2024, Levente Hunyadi
+-- https://github.com/hunyadi/yaml-to-json
+
+CREATE OR REPLACE FUNCTION
+  YAML_SCHEMA(YAML_ARRAY BINARY)
+  RETURNS TABLE (PATH VARCHAR, TYPE VARCHAR, COUNT NUMBER, MAX_LENGTH NUMBER)
+  LANGUAGE JAVASCRIPT
+  COMMENT = 'Aggregates the paths (e.g. a.b[].c), JSON value types and maximum lengths found in YAML binary strings encoded in UTF-8, one row per path and type for each partition. Malformed documents are counted in a row whose type is error.'
+AS
+$$
+{
+    initialize: function (argumentInfo, context) {
+@@BASE64_DECODER@@
+
+@@INSTANCE_MANAGER@@
+
+        function setup(Module, WebAssembly) {
+@@EMSCRIPTEN_OUTPUT@@
+        }
+
+        // the aggregate lives in Wasm memory, so an instance is only replaced between partitions
+        globalThis.YAML_SCHEMA_MODULE = acquire_instance(setup, globalThis.YAML_SCHEMA_MODULE);
+        this.schema = globalThis.YAML_SCHEMA_MODULE.schema_begin();
+    },
+
+    processRow: function (row, rowWriter, context) {
+        if (row.YAML_ARRAY) {
+            this.schema.add(row.YAML_ARRAY);
+        }
+    },
+
+    finalize: function (rowWriter, context) {
+        const result = this.schema.result();
+        this.schema.delete();
+        for (const [path, type, count, max_length] of result.paths) {
+            rowWriter.writeRow({ PATH: path, TYPE: type, COUNT: count, MAX_LENGTH: max_length });
+        }
+        if (result.errors) {
+            rowWriter.writeRow({ PATH: null, TYPE: "error", COUNT: result.errors, MAX_LENGTH: null });
+        }
+        if (result.dropped) {
+            rowWriter.writeRow({ PATH: null, TYPE: "dropped", COUNT: result.dropped, MAX_LENGTH: null });
+        }
+    }
+}
+$$
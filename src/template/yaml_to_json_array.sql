@@ -15,14 +15,13 @@ AS
 $$
 @@BASE64_DECODER@@
 
-function setup(Module) {
+@@INSTANCE_MANAGER@@
+
+function setup(Module, WebAssembly) {
 @@EMSCRIPTEN_OUTPUT@@
 }
 
-if (typeof(Module) === "undefined") {
-  Module = {};
-  setup(Module);
-}
+Module = acquire_instance(setup, typeof(Module) === "undefined" ? undefined : Module);
 
 return Module.yaml_to_json_array(YAML_ARRAY);
 $$;
@@ -0,0 +1,38 @@
+--
+-- Converts YAML to JSON with Wasm, or reports why conversion has failed.
+--
+-- Copyright 2024, Levente Hunyadi
+-- https://github.com/hunyadi/yaml-to-json
+
+CREATE OR REPLACE FUNCTION
+  YAML_TO_JSON_OR_ERROR(YAML_STRING VARCHAR)
+  RETURNS OBJECT
+  LANGUAGE JAVASCRIPT
+  RETURNS NULL ON NULL INPUT
+  IMMUTABLE
+  COMMENT = 'Converts a YAML string to an object whose field `json` is a JSON string, or whose field `error` describes why conversion has failed.'
+AS
+$$
+@@BASE64_DECODER@@
+
+@@INSTANCE_MANAGER@@
+
+function setup(Module, WebAssembly) {
+@@EMSCRIPTEN_OUTPUT@@
+}
+
+Module = acquire_instance(setup, typeof(Module) === "undefined" ? undefined : Module);
+
+return Module.yaml_to_json_or_error(YAML_STRING);
+$$;
+
+CREATE OR REPLACE FUNCTION
+  YAML_PARSE_OR_ERROR(YAML_STRING VARCHAR)
+  RETURNS OBJECT
+  LANGUAGE SQL
+  COMMENT = 'Parses a YAML string into an object whose field `json` is a semi-structured value, or whose field `error` describes why parsing has failed.'
+AS
+$$
+  SELECT OBJECT_CONSTRUCT_KEEP_NULL('json', PARSE_JSON(RESULT:json::VARCHAR), 'error', RESULT:error::VARCHAR)
+  FROM (SELECT YAML_TO_JSON_OR_ERROR(YAML_STRING) AS RESULT)
+$$
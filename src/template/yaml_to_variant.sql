@@ -0,0 +1,38 @@
+--
+-- Converts YAML to semi-structured values with Wasm.
+--
+-- Copyright 2024, Levente Hunyadi
+-- https://github.com/hunyadi/yaml-to-json
+
+CREATE OR REPLACE FUNCTION
+  YAML_TO_VARIANT(YAML_ARRAY BINARY)
+  RETURNS VARIANT
+  LANGUAGE JAVASCRIPT
+  RETURNS NULL ON NULL INPUT
+  IMMUTABLE
+  COMMENT = 'Converts a YAML binary string encoded in UTF-8 to a semi-structured value, without producing JSON text.'
+AS
+$$
+@@BASE64_DECODER@@
+
+@@INSTANCE_MANAGER@@
+
+function setup(Module, WebAssembly) {
+@@EMSCRIPTEN_OUTPUT@@
+}
+
+Module = acquire_instance(setup, typeof(Module) === "undefined" ? undefined : Module);
+
+const value = Module.yaml_to_object(YAML_ARRAY);
+return value === undefined ? null : value;
+$$;
+
+CREATE OR REPLACE FUNCTION
+  YAML_PARSE(YAML_STRING VARCHAR)
+  RETURNS VARIANT
+  LANGUAGE SQL
+  COMMENT = 'Parses a YAML string into a semi-structured value.'
+AS
+$$
+  YAML_TO_VARIANT(TO_BINARY(YAML_STRING, 'UTF-8'))
+$$
@@ -5,9 +5,13 @@
 **/
 
 #include "utf8.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdlib>
 #include <cstdint>
+#include <thread>
+#include <vector>
 
 /* The following constants are truncated on 32-bit machines */
 constexpr std::size_t C_UTF8_ASCII_MASK = static_cast<std::size_t>(UINT64_C(0x8080808080808080));
@@ -256,3 +260,60 @@ out:
         lenp = len;
     }
 }
+
+bool utf8::is_valid(const char* str, std::size_t len, std::size_t& pos, std::size_t threads)
+{
+    std::size_t chunk_count = std::min(4 * threads, len / min_chunk_bytes);
+    if (threads < 2 || len < min_parallel_bytes || chunk_count < 2) {
+        return is_valid(str, len, pos);
+    }
+
+    // start each chunk at a byte that is not a continuation byte, where a serial check either starts a new character
+    // or has already failed in the chunk before; an invalid run of continuation bytes may be longer than any valid
+    // sequence, so back up as far as the start of the previous chunk (which leaves that chunk empty)
+    std::vector<std::size_t> bounds(chunk_count + 1);
+    bounds[0] = 0;
+    bounds[chunk_count] = len;
+    for (std::size_t k = 1; k < chunk_count; ++k) {
+        std::size_t bound = std::max(len * k / chunk_count, bounds[k - 1]);
+        while (bound > bounds[k - 1] && C_UTF8_CHAR_IS_TAIL(c_load_8(str, bound))) {
+            --bound;
+        }
+        bounds[k] = bound;
+    }
+
+    // within a valid prefix, chunks are validated in step with the single-threaded check, such that the first chunk
+    // that fails does so at the same offset; chunks after the first that has failed are skipped
+    std::vector<std::size_t> failures(chunk_count, SIZE_MAX);
+    std::atomic<std::size_t> first_failed(chunk_count);
+    std::atomic<std::size_t> next(0);
+    auto validate = [&]() {
+        for (std::size_t k = next++; k < chunk_count; k = next++) {
+            if (k > first_failed.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            std::size_t offset;
+            if (!is_valid(str + bounds[k], bounds[k + 1] - bounds[k], offset)) {
+                failures[k] = bounds[k] + offset;
+                std::size_t current = first_failed.load();
+                while (k < current && !first_failed.compare_exchange_weak(current, k)) {
+                }
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t k = 1; k < std::min(threads, chunk_count); ++k) {
+        pool.emplace_back(validate);
+    }
+    validate();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    std::size_t k = first_failed.load();
+    if (k == chunk_count) {
+        return true;
+    }
+    pos = failures[k];
+    return false;
+}
@@ -5,10 +5,17 @@
 **/
 
 #pragma once
+#include <cstddef>
 #include <string>
 
 namespace utf8
 {
+    /** Strings shorter than this number of bytes are validated on the calling thread. */
+    constexpr std::size_t min_parallel_bytes = 16 << 20;
+
+    /** Chunks validated in parallel are at least this number of bytes long. */
+    constexpr std::size_t min_chunk_bytes = 1 << 20;
+
     namespace detail
     {
         void utf8_verify_ascii(const char*& strp, std::size_t& lenp);
@@ -40,4 +47,13 @@ namespace utf8
     {
         return is_valid(str.data(), str.size(), pos);
     }
+
+    /**
+     * Checks if a UTF-8 string is valid, validating chunks of a long string on a number of threads.
+     *
+     * Chunks start at a code point boundary (backing up over continuation bytes), such that the invalid position
+     * reported is the same as that of the single-threaded check: the lowest offset at which validation fails.
+     * @returns True if the string is valid UTF-8.
+     */
+    bool is_valid(const char* str, std::size_t len, std::size_t& pos, std::size_t threads);
 }
@@ -8,7 +8,7 @@ function check_yaml(yaml) {
     const yaml_string = _string_create(yaml.length);
     try {
         const yaml_buffer = _string_data(yaml_string);
-        Module.HEAPU8.set(yaml, yaml_buffer);
+        heap_bytes().set(yaml, yaml_buffer);
         const message = _check_yaml(yaml_string);
         if (!message) {
             return null;
@@ -16,7 +16,7 @@ function check_yaml(yaml) {
         try {
             const message_length = _string_length(message);
             const message_buffer = _string_data(message);
-            return Module.HEAPU8.slice(message_buffer, message_buffer + message_length);
+            return heap_bytes().slice(message_buffer, message_buffer + message_length);
         } finally {
             _string_delete(message);
         }
@@ -25,3 +25,33 @@ function check_yaml(yaml) {
     }
 }
 Module["check_yaml"] = check_yaml;
+
+/**
+ * Maps names of limits to identifiers recognized by `check_configure`.
+ */
+const check_options = {
+    "max_depth": 2,
+    "max_input_bytes": 3,
+    "max_nodes": 4,
+    "max_output_bytes": 5,
+    "expand_aliases": 6,
+    "max_expansion_bytes": 7
+};
+
+/**
+ * Changes limits that documents must observe to pass the check, and how aliases are treated.
+ *
+ * @param {Object.<string, number>} options Limits to change, e.g. `max_nodes` (zero for no limit), or `expand_aliases` to
+ * check that aliases and merge keys refer to existing anchors and maps. With `expand_aliases`, aliases and merge keys
+ * are replaced with what they refer to, writing at most `max_expansion_bytes` on their behalf; documents that exceed a
+ * limit fail the check.
+ */
+function configure(options) {
+    for (const [name, value] of Object.entries(options)) {
+        const option = check_options[name];
+        if (!option || !_check_configure(option, value)) {
+            throw new Error(`unrecognized option: ${name}`);
+        }
+    }
+}
+Module["configure"] = configure;
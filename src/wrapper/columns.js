@@ -0,0 +1,97 @@
+/**
+ * The column set compiled for the most recently used list of paths, which is re-used while the paths stay the same.
+ */
+let compiled_columns = { key: null, columns: 0 };
+
+/**
+ * Returns a column set (see `src/columns.hpp`) for a list of paths, compiling the paths only when they change.
+ *
+ * @param {string[]} paths Paths to nodes.
+ * @returns {number} The column set, or zero if a path is malformed.
+ */
+function compile_columns(paths) {
+    const key = paths.join("\0");
+    if (compiled_columns.key === key) {
+        return compiled_columns.columns;
+    }
+
+    const bytes = encode_utf8(key);
+    const paths_string = _string_create(bytes.length);
+    let columns;
+    try {
+        heap_bytes().set(bytes, _string_data(paths_string));
+        columns = _columns_compile(paths_string);
+    } finally {
+        _string_delete(paths_string);
+    }
+    if (!columns) {
+        return 0;
+    }
+
+    if (compiled_columns.columns) {
+        _columns_delete(compiled_columns.columns);
+    }
+    compiled_columns = { key: key, columns: columns };
+    return columns;
+}
+
+/**
+ * Extracts the values at a fixed list of paths from a batch of YAML documents with Wasm, resolving all paths of a
+ * document in a single walk of its tree.
+ *
+ * @param {Uint8Array[]} yamls The YAML strings to parse.
+ * @param {string[]} paths Paths to nodes, e.g. `a.b[0].c` (see `YamlDocument`).
+ * @returns {Array<Array<*>> | null} One array per path, with the value at the path in each document (`undefined` if
+ * there is no node at the path or the document is malformed), or `null` if a path is malformed.
+ */
+function yaml_to_columns(yamls, paths) {
+    const columns = compile_columns(paths);
+    if (!columns) {
+        return null;
+    }
+
+    for (const yaml of yamls) {
+        const yaml_string = _string_create(yaml.length);
+        try {
+            heap_bytes().set(yaml, _string_data(yaml_string));
+            _transform_yaml_columns(yaml_string, columns);
+        } finally {
+            _string_delete(yaml_string);
+        }
+    }
+
+    let result;
+    const result_string = _columns_result(columns);
+    try {
+        const result_buffer = _string_data(result_string);
+        result = heap_bytes().slice(result_buffer, result_buffer + _string_length(result_string));
+    } finally {
+        _string_delete(result_string);
+    }
+
+    // column and row count, followed by the length of each cell column by column, and the JSON text of all cells
+    const header = new Uint32Array(result.buffer, 0, 2);
+    const column_count = header[0];
+    const row_count = header[1];
+    const lengths = new Uint32Array(result.buffer, 8, column_count * row_count);
+    let offset = 4 * (2 + column_count * row_count);
+    const values = [];
+    for (let k = 0; k < column_count; ++k) {
+        const column = new Array(row_count);
+        for (let i = 0; i < row_count; ++i) {
+            const length = lengths[k * row_count + i];
+            if (length === 0xFFFFFFFF) {
+                column[i] = undefined;
+            } else if (length === 0) {
+                // empty document
+                column[i] = null;
+            } else {
+                column[i] = JSON.parse(decode_utf8(result, offset, offset + length));
+                offset += length;
+            }
+        }
+        values.push(column);
+    }
+    return values;
+}
+Module["yaml_to_columns"] = yaml_to_columns;
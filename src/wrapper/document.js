@@ -0,0 +1,134 @@
+/**
+ * Maps identifiers returned by `doc_type` to names of JSON value types.
+ */
+const document_types = [undefined, "null", "boolean", "number", "string", "array", "object"];
+
+/**
+ * Encodes a string as UTF-8 (`TextEncoder` is not available in all engines, e.g. Snowflake).
+ *
+ * @param {string} str The string to encode.
+ * @returns {number[]} UTF-8 bytes.
+ */
+function encode_utf8(str) {
+    const bytes = [];
+    for (let i = 0; i < str.length; ++i) {
+        let c = str.charCodeAt(i);
+        if (c >= 0xD800 && c < 0xDC00 && i + 1 < str.length) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (str.charCodeAt(++i) - 0xDC00);
+        }
+        if (c < 0x80) {
+            bytes.push(c);
+        } else if (c < 0x800) {
+            bytes.push(0xC0 | (c >> 6), 0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            bytes.push(0xE0 | (c >> 12), 0x80 | ((c >> 6) & 0x3F), 0x80 | (c & 0x3F));
+        } else {
+            bytes.push(0xF0 | (c >> 18), 0x80 | ((c >> 12) & 0x3F), 0x80 | ((c >> 6) & 0x3F), 0x80 | (c & 0x3F));
+        }
+    }
+    return bytes;
+}
+
+/**
+ * A YAML document parsed once and kept in Wasm memory, which answers lookups by path without converting the entire
+ * document to JSON.
+ *
+ * A path is a sequence of keys separated by `.`, and indexes in square brackets, e.g. `a.b[0].c`; use `["a.b"]` for
+ * keys that contain `.` or `[`. The empty path refers to the entire document.
+ *
+ * At most 16 documents may be open at the same time; call `close` when done.
+ */
+class YamlDocument {
+    constructor(handle) {
+        this.handle = handle;
+    }
+
+    /**
+     * Calls a Wasm function with a path copied into Wasm memory.
+     *
+     * @param {string} path Path to a node.
+     * @param {function(number, number): *} fn Function that takes the document handle and the path string.
+     * @returns {*} Whatever the function returns.
+     */
+    with_path(path, fn) {
+        const bytes = encode_utf8(path);
+        const path_string = _string_create(bytes.length);
+        try {
+            heap_bytes().set(bytes, _string_data(path_string));
+            return fn(this.handle, path_string);
+        } finally {
+            _string_delete(path_string);
+        }
+    }
+
+    /**
+     * Converts the node at a path to a JavaScript value.
+     *
+     * @param {string} path Path to a node.
+     * @returns {*} The value at the path, or `undefined` if there is no such node or conversion fails.
+     */
+    get(path) {
+        const json_string = this.with_path(path, _doc_get);
+        if (!json_string) {
+            return undefined;
+        }
+        try {
+            const json_length = _string_length(json_string);
+            if (json_length === 0) {
+                // empty document
+                return null;
+            }
+            const json_buffer = _string_data(json_string);
+            return JSON.parse(decode_utf8(heap_bytes(), json_buffer, json_buffer + json_length));
+        } finally {
+            _string_delete(json_string);
+        }
+    }
+
+    /**
+     * Determines the type of the node at a path.
+     *
+     * @param {string} path Path to a node.
+     * @returns {string | undefined} One of `null`, `boolean`, `number`, `string`, `array` or `object`, or `undefined`
+     * if there is no such node.
+     */
+    type(path) {
+        return document_types[this.with_path(path, _doc_type)];
+    }
+
+    /**
+     * Counts the items of the array (or the entries of the object) at a path.
+     *
+     * @param {string} path Path to a node.
+     * @returns {number | undefined} Number of items or entries, or `undefined` if the node is not an array or object.
+     */
+    length(path) {
+        const length = this.with_path(path, _doc_len);
+        return length >= 0 ? length : undefined;
+    }
+
+    /**
+     * Releases the document.
+     */
+    close() {
+        _doc_close(this.handle);
+        this.handle = 0;
+    }
+}
+
+/**
+ * Parses YAML with Wasm, and keeps the document for lookups by path.
+ *
+ * @param {Uint8Array} yaml The YAML string to parse.
+ * @returns {YamlDocument | null} The open document, or `null` if the YAML string is malformed, exceeds a budget, or
+ * too many documents are open.
+ */
+function yaml_open(yaml) {
+    const yaml_string = _string_create(yaml.length);
+    heap_bytes().set(yaml, _string_data(yaml_string));
+
+    // the document takes ownership of the string
+    const handle = _doc_open(yaml_string);
+    return handle ? new YamlDocument(handle) : null;
+}
+Module["yaml_open"] = yaml_open;
@@ -0,0 +1,22 @@
+/**
+ * Returns a view of Wasm memory as an array of bytes.
+ *
+ * When the heap grows, Wasm memory is backed by a new `ArrayBuffer`, and views of the old buffer become detached.
+ * Do not hold on to the view across calls into Wasm that may allocate memory; call this function again instead.
+ *
+ * @returns {Uint8Array} A view of the entire Wasm heap.
+ */
+function heap_bytes() {
+    const heap = Module.HEAPU8;
+    return heap.buffer === wasmMemory.buffer ? heap : new Uint8Array(wasmMemory.buffer);
+}
+
+/**
+ * Returns the current size of Wasm memory.
+ *
+ * @returns {number} Size of the heap in bytes.
+ */
+function heap_size() {
+    return wasmMemory.buffer.byteLength;
+}
+Module["heap_size"] = heap_size;
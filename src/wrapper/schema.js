@@ -0,0 +1,74 @@
+/**
+ * Aggregates the structure of YAML documents in Wasm memory, without converting them to JSON.
+ *
+ * For each path (e.g. `a.b[].c`, where `[]` stands for any item of an array), the aggregate counts how many times
+ * each JSON value type has been seen, and keeps the maximum length of those values: the number of bytes of a scalar,
+ * or the number of items (or entries) of an array (or object).
+ *
+ * Call `delete` when done, because the aggregate is not released by the garbage collector.
+ */
+class YamlSchema {
+    constructor() {
+        this.schema = _schema_begin();
+    }
+
+    /**
+     * Records the paths and value types of a YAML document.
+     *
+     * @param {Uint8Array} yaml The YAML string to parse.
+     * @returns {boolean} False if the document is malformed (which is counted as an error).
+     */
+    add(yaml) {
+        const yaml_string = _string_create(yaml.length);
+        try {
+            heap_bytes().set(yaml, _string_data(yaml_string));
+            return !!_schema_add(this.schema, yaml_string);
+        } finally {
+            _string_delete(yaml_string);
+        }
+    }
+
+    /**
+     * Adds the counts of another aggregate (of the same Wasm instance) to this aggregate.
+     *
+     * @param {YamlSchema} other The aggregate to merge.
+     */
+    merge(other) {
+        _schema_merge(this.schema, other.schema);
+    }
+
+    /**
+     * Returns the aggregate.
+     *
+     * @returns {{rows: number, errors: number, dropped: number, paths: Array<[string, string, number, number]>}}
+     * Number of documents recorded, number of malformed documents, number of values at paths beyond the limit of
+     * distinct paths, and `[path, type, count, max_length]` entries in the order paths have been first seen.
+     */
+    result() {
+        const json_string = _schema_result(this.schema);
+        try {
+            const json_buffer = _string_data(json_string);
+            return JSON.parse(decode_utf8(heap_bytes(), json_buffer, json_buffer + _string_length(json_string)));
+        } finally {
+            _string_delete(json_string);
+        }
+    }
+
+    /**
+     * Releases the aggregate.
+     */
+    delete() {
+        _schema_delete(this.schema);
+        this.schema = 0;
+    }
+}
+
+/**
+ * Creates an empty aggregate of the structure of YAML documents.
+ *
+ * @returns {YamlSchema} A new aggregate.
+ */
+function schema_begin() {
+    return new YamlSchema();
+}
+Module["schema_begin"] = schema_begin;
@@ -0,0 +1,61 @@
+/**
+ * Maps names of settings to identifiers recognized by `transform_configure`.
+ */
+const transform_options = {
+    "cache_capacity": 1,
+    "max_depth": 2,
+    "max_input_bytes": 3,
+    "max_nodes": 4,
+    "max_output_bytes": 5,
+    "expand_aliases": 6,
+    "max_expansion_bytes": 7
+};
+
+/**
+ * Maps names of counters to identifiers recognized by `transform_statistic`.
+ */
+const transform_statistics = {
+    "cache_hits": 1,
+    "cache_misses": 2,
+    "cache_evictions": 3,
+    "cache_entries": 4,
+    "cache_bytes": 5,
+    "rows": 6,
+    "json_fast_path": 7,
+    "node_regrowths": 8,
+    "arena_regrowths": 9,
+    "open_documents": 10
+};
+
+/**
+ * Changes settings of the YAML to JSON conversion function.
+ *
+ * @param {Object.<string, number>} options Settings to change, e.g. `cache_capacity` (in bytes, zero turns off caching),
+ * or per-document limits `max_depth`, `max_input_bytes`, `max_nodes` and `max_output_bytes` (zero for no limit except
+ * for depth); documents that exceed a limit convert to `null`. With `expand_aliases`, aliases and merge keys are replaced
+ * with what they refer to, writing at most `max_expansion_bytes` on their behalf.
+ */
+function configure(options) {
+    for (const [name, value] of Object.entries(options)) {
+        const option = transform_options[name];
+        if (!option || !_transform_configure(option, value)) {
+            throw new Error(`unrecognized option: ${name}`);
+        }
+    }
+}
+Module["configure"] = configure;
+
+/**
+ * Reports on the operation of the YAML to JSON conversion function.
+ *
+ * @returns {Object.<string, number>} Current value of counters.
+ */
+function statistics() {
+    const result = {};
+    for (const [name, statistic] of Object.entries(transform_statistics)) {
+        result[name] = _transform_statistic(statistic) >>> 0;
+    }
+    result["json_fast_path_fraction"] = result["rows"] ? result["json_fast_path"] / result["rows"] : 0;
+    return result;
+}
+Module["statistics"] = statistics;
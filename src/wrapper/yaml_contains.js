@@ -0,0 +1,26 @@
+/**
+ * Checks with Wasm if the node at a path of a YAML document is a scalar equal to a value, without converting the
+ * document to JSON.
+ *
+ * Parsing stops as soon as the result is known; the rest of the document is not checked. Scalars are compared as text
+ * after quotes and escapes are resolved, e.g. `8080` and `'8080'` both equal `"8080"`.
+ *
+ * @param {Uint8Array} yaml The YAML string to parse.
+ * @param {string} path Path to a node, e.g. `a.b[0].c` (see `YamlDocument`).
+ * @param {string} value The value to compare against.
+ * @returns {boolean | null} Whether the value is found, or `null` if the document is malformed or the path is invalid.
+ */
+function yaml_contains(yaml, path, value) {
+    const strings = [yaml, encode_utf8(path), encode_utf8(value)].map(bytes => {
+        const string = _string_create(bytes.length);
+        heap_bytes().set(bytes, _string_data(string));
+        return string;
+    });
+    try {
+        const result = _yaml_contains(strings[0], strings[1], strings[2]);
+        return result < 0 ? null : result > 0;
+    } finally {
+        strings.forEach(string => _string_delete(string));
+    }
+}
+Module["yaml_contains"] = yaml_contains;
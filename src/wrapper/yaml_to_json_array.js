@@ -8,7 +8,7 @@ function yaml_to_json_array(yaml) {
     const yaml_string = _string_create(yaml.length);
     try {
         const yaml_buffer = _string_data(yaml_string);
-        Module.HEAPU8.set(yaml, yaml_buffer);
+        heap_bytes().set(yaml, yaml_buffer);
         const json_string = _transform_yaml(yaml_string);
         if (!json_string) {
             return null;
@@ -16,7 +16,7 @@ function yaml_to_json_array(yaml) {
         try {
             const json_length = _string_length(json_string);
             const json_buffer = _string_data(json_string);
-            return Module.HEAPU8.slice(json_buffer, json_buffer + json_length);
+            return heap_bytes().slice(json_buffer, json_buffer + json_length);
         } finally {
             _string_delete(json_string);
         }
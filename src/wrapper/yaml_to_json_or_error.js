@@ -0,0 +1,34 @@
+/**
+ * Converts YAML to JSON with Wasm, or describes why conversion has failed.
+ *
+ * Failing documents are parsed only once, unlike when calling `check_yaml` on documents that convert to `null`.
+ *
+ * @param {string} yaml The YAML string to parse.
+ * @returns {{json: string | null, error: string | null}} The JSON string generated, or the parse or validation error.
+ */
+function yaml_to_json_or_error(yaml) {
+    const yaml_length = lengthBytesUTF8(yaml);
+    const yaml_string = _string_create(yaml_length);
+    try {
+        const yaml_buffer = _string_data(yaml_string);
+        stringToUTF8(yaml, yaml_buffer, yaml_length + 1);
+
+        const result_string = _transform_yaml_or_error(yaml_string);
+        try {
+            // the first character tags the result as JSON (`J`) or error message (`E`)
+            const result_length = _string_length(result_string);
+            const result_buffer = _string_data(result_string);
+            const text = UTF8ToString(result_buffer + 1, result_length - 1);
+            if (UTF8ToString(result_buffer, 1) === "J") {
+                return { "json": text, "error": null };
+            } else {
+                return { "json": null, "error": text };
+            }
+        } finally {
+            _string_delete(result_string);
+        }
+    } finally {
+        _string_delete(yaml_string);
+    }
+}
+Module["yaml_to_json_or_error"] = yaml_to_json_or_error;
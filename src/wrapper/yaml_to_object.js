@@ -0,0 +1,135 @@
+/**
+ * Decodes UTF-8 text when `TextDecoder` is available (e.g. not in Snowflake).
+ */
+const tape_decoder = typeof TextDecoder !== "undefined" ? new TextDecoder("utf-8") : null;
+
+/**
+ * Decodes a valid UTF-8 byte sequence into a string.
+ *
+ * @param {Uint8Array} bytes Buffer that holds the byte sequence.
+ * @param {number} start Index of the first byte.
+ * @param {number} end Index one past the last byte.
+ * @returns {string} The decoded string.
+ */
+function decode_utf8(bytes, start, end) {
+    if (tape_decoder && end - start > 16) {
+        return tape_decoder.decode(bytes.subarray(start, end));
+    }
+
+    let result = "";
+    const codes = [];
+    let i = start;
+    while (i < end) {
+        let c = bytes[i++];
+        if (c >= 0xF0) {
+            c = ((c & 0x07) << 18) | ((bytes[i++] & 0x3F) << 12) | ((bytes[i++] & 0x3F) << 6) | (bytes[i++] & 0x3F);
+            c -= 0x10000;
+            codes.push(0xD800 | (c >> 10), 0xDC00 | (c & 0x3FF));
+        } else if (c >= 0xE0) {
+            codes.push(((c & 0x0F) << 12) | ((bytes[i++] & 0x3F) << 6) | (bytes[i++] & 0x3F));
+        } else if (c >= 0xC0) {
+            codes.push(((c & 0x1F) << 6) | (bytes[i++] & 0x3F));
+        } else {
+            codes.push(c);
+        }
+
+        // avoid exceeding the maximum number of function arguments
+        if (codes.length >= 8192) {
+            result += String.fromCharCode.apply(null, codes);
+            codes.length = 0;
+        }
+    }
+    return result + String.fromCharCode.apply(null, codes);
+}
+
+/**
+ * Builds JavaScript values from a tape (see `src/tape.hpp`).
+ *
+ * @param {Uint8Array} tape The tape, starting at a 4-byte aligned offset.
+ * @returns {*} The value the tape represents.
+ */
+function tape_to_value(tape) {
+    const count = tape.length > 0 ? new Uint32Array(tape.buffer, tape.byteOffset, 1)[0] : 0;
+    if (count === 0) {
+        // empty document
+        return null;
+    }
+    const entries = new Uint32Array(tape.buffer, tape.byteOffset + 4, count);
+    let index = 0;
+    let offset = 4 * (count + 1);
+
+    function text(length) {
+        const str = decode_utf8(tape, offset, offset + length);
+        offset += length;
+        return str;
+    }
+
+    function value() {
+        const entry = entries[index++];
+        const payload = entry >>> 3;
+        switch (entry & 7) {
+            case 0:
+                return null;
+            case 1:
+                return false;
+            case 2:
+                return true;
+            case 3:
+                return +text(payload);
+            case 4:
+                return text(payload);
+            case 5: {
+                const array = new Array(payload);
+                for (let k = 0; k < payload; ++k) {
+                    array[k] = value();
+                }
+                return array;
+            }
+            case 6: {
+                const object = {};
+                for (let k = 0; k < payload; ++k) {
+                    const key = value();
+                    if (key === "__proto__") {
+                        // an own property as with `JSON.parse`, assignment would set the prototype instead
+                        Object.defineProperty(object, key, { value: value(), enumerable: true, writable: true, configurable: true });
+                    } else {
+                        object[key] = value();
+                    }
+                }
+                return object;
+            }
+        }
+    }
+
+    return value();
+}
+
+/**
+ * Converts YAML to JavaScript values with Wasm, without producing and parsing JSON text.
+ *
+ * @param {Uint8Array} yaml The YAML string to parse.
+ * @returns {*} The value the YAML document represents, or `undefined` if conversion fails.
+ */
+function yaml_to_object(yaml) {
+    const yaml_string = _string_create(yaml.length);
+    try {
+        const yaml_buffer = _string_data(yaml_string);
+        heap_bytes().set(yaml, yaml_buffer);
+        const tape_string = _transform_yaml_tape(yaml_string);
+        if (!tape_string) {
+            return undefined;
+        }
+        let tape;
+        try {
+            const tape_length = _string_length(tape_string);
+            const tape_buffer = _string_data(tape_string);
+            tape = heap_bytes().slice(tape_buffer, tape_buffer + tape_length);
+        } finally {
+            _string_delete(tape_string);
+        }
+        return tape_to_value(tape);
+    } finally {
+        _string_delete(yaml_string);
+    }
+}
+Module["yaml_to_object"] = yaml_to_object;
@@ -0,0 +1,523 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#include "yaml.hpp"
+#include "json.hpp"
+#include "path.hpp"
+#include "simd.hpp"
+#include "tape.hpp"
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/** Capacity of the parser stack, reserved once (sufficient for the default nesting depth limit). */
+constexpr ryml::id_type parser_stack_capacity = 72;
+
+// parser state is kept per thread, such that threads of a native host may convert documents in parallel
+static thread_local std::jmp_buf parse_error_handler;
+static thread_local std::string error_message;
+static thread_local yaml::Statistics statistics;
+
+/**
+ * Decides whether the value at a path equals a scalar while the tree is being built, as soon as the part of the
+ * document that holds the path has been parsed.
+ *
+ * Children of the deepest container on the path found so far are examined in document order once they are complete
+ * (or, for containers, once they have started and have a key), such that each node is examined once.
+ */
+struct Matcher
+{
+    const std::vector<path::Segment>* segments = nullptr;
+    ryml::csubstr value;
+
+    /** Deepest container on the path found so far, and the number of segments that lead to it. */
+    ryml::id_type prefix = ryml::NONE;
+    std::size_t level = 0;
+    /** True once the prefix container has ended. */
+    bool prefix_complete = false;
+    /** Last child of the prefix container examined, and the number of children examined. */
+    ryml::id_type examined = ryml::NONE;
+    std::size_t position = 0;
+    /** Container that has ended most recently. */
+    ryml::id_type ended = ryml::NONE;
+
+    bool decided = false;
+    bool found = false;
+
+    void reset(const std::vector<path::Segment>& segments, ryml::csubstr value, ryml::id_type root)
+    {
+        *this = Matcher();
+        this->segments = &segments;
+        this->value = value;
+        this->prefix = root;
+    }
+
+    /** True if the node at the end of the segments that start at a complete node is a scalar equal to the value. */
+    bool equals(const ryml::Tree& tree, ryml::id_type node, std::size_t level) const
+    {
+        const path::Segment* begin = segments->data();
+        node = path::find(tree, node, begin + level, begin + segments->size());
+        return node != ryml::NONE && tree.has_val(node) && !tree.is_container(node) && tree.val(node) == value;
+    }
+
+    /** Examines nodes added to the tree since the last call. */
+    void advance(const ryml::Tree& tree)
+    {
+        if (tree.is_stream(tree.root_id())) {
+            // the children of the root have moved to the first document
+            prefix = ryml::NONE;
+        }
+        if (prefix == ryml::NONE || !tree.is_container(prefix) || segments->empty()) {
+            return;
+        }
+
+        while (true) {
+            const path::Segment& segment = (*segments)[level];
+            if (segment.is_index ? !tree.is_seq(prefix) : !tree.is_map(prefix)) {
+                decide(false);
+                return;
+            }
+
+            ryml::id_type child = examined == ryml::NONE ? tree.first_child(prefix) : tree.next_sibling(examined);
+            if (child == ryml::NONE) {
+                if (prefix_complete) {
+                    decide(false);
+                }
+                return;
+            }
+            bool complete = tree.next_sibling(child) != ryml::NONE || prefix_complete || child == ended;
+            bool container = tree.is_container(child);
+            if (!complete && !container) {
+                // a scalar in progress
+                return;
+            }
+
+            if (path::matches(tree, child, position, segment)) {
+                if (level + 1 == segments->size()) {
+                    decide(!container && equals(tree, child, level + 1));
+                    return;
+                } else if (complete) {
+                    decide(equals(tree, child, level + 1));
+                    return;
+                }
+
+                // descend into a container in progress
+                prefix = child;
+                ++level;
+                prefix_complete = false;
+                examined = ryml::NONE;
+                position = 0;
+                continue;
+            }
+            examined = child;
+            ++position;
+        }
+    }
+
+    void decide(bool result)
+    {
+        decided = true;
+        found = result;
+    }
+};
+
+/** Builds a tree like `ryml::EventHandlerTree`, and raises an error as soon as the tree exceeds a number of nodes. */
+struct BudgetEventHandler : public ryml::EventHandlerTree
+{
+    ryml::id_type max_nodes = ryml::NONE;
+    /** Stops parsing once the matcher (if any) has reached a decision. */
+    Matcher* matcher = nullptr;
+
+    // events that may append a node to the tree
+
+    void begin_map_val_flow()
+    {
+        EventHandlerTree::begin_map_val_flow();
+        check_budget();
+        observe();
+    }
+
+    void begin_map_val_block()
+    {
+        EventHandlerTree::begin_map_val_block();
+        check_budget();
+        observe();
+    }
+
+    void begin_seq_val_flow()
+    {
+        EventHandlerTree::begin_seq_val_flow();
+        check_budget();
+        observe();
+    }
+
+    void begin_seq_val_block()
+    {
+        EventHandlerTree::begin_seq_val_block();
+        check_budget();
+        observe();
+    }
+
+    void add_sibling()
+    {
+        EventHandlerTree::add_sibling();
+        check_budget();
+        observe();
+    }
+
+    // events that complete a node
+
+    void end_map()
+    {
+        EventHandlerTree::end_map();
+        end_container();
+    }
+
+    void end_seq()
+    {
+        EventHandlerTree::end_seq();
+        end_container();
+    }
+
+private:
+    void check_budget()
+    {
+        if (m_tree->size() > max_nodes) {
+            constexpr const char* msg = "max nodes exceeded";
+            m_stack.m_callbacks.m_error(msg, std::strlen(msg), m_curr->pos, m_stack.m_callbacks.m_user_data);
+        }
+    }
+
+    void end_container()
+    {
+        if (matcher) {
+            matcher->ended = m_curr->node_id;
+            if (m_curr->node_id == matcher->prefix) {
+                matcher->prefix_complete = true;
+            }
+            observe();
+        }
+    }
+
+    void observe()
+    {
+        if (matcher) {
+            matcher->advance(*m_tree);
+            if (matcher->decided) {
+                // the rest of the document does not affect the result
+                longjmp(parse_error_handler, 1);
+            }
+        }
+    }
+};
+
+/** Parser state reused across calls to avoid repeated allocations. */
+struct ParseContext
+{
+    BudgetEventHandler event_handler;
+    ryml::ParseEngine<BudgetEventHandler> parser;
+    ryml::Tree tree;
+
+    ParseContext()
+        : event_handler()
+        , parser(&event_handler)
+        , tree()
+    {
+    }
+};
+
+/** Parser state of the calling thread, created by `yaml::initialize`. */
+static thread_local std::unique_ptr<ParseContext> context;
+
+/** Returns the parser state of the calling thread, setting it up on first use. */
+static ParseContext& thread_context()
+{
+    if (!context) {
+        yaml::initialize();
+    }
+    return *context;
+}
+
+static void* parser_allocate(size_t len, void* hint, void* user_data)
+{
+    return std::malloc(len);
+}
+
+static void parser_free(void* mem, size_t size, void* user_data)
+{
+    std::free(mem);
+}
+
+static void parser_raise(const char* msg, size_t len, ryml::Location location, void* user_data)
+{
+    constexpr const char* fmt = "%.*s in YAML at line %zu column %zu offset %zu";
+    int count = std::snprintf(nullptr, 0, fmt, static_cast<int>(len), msg, location.line, location.col, location.offset);
+    if (count >= 0) {
+        error_message.resize(count + 1);
+        std::snprintf(error_message.data(), error_message.size(), fmt, static_cast<int>(len), msg, location.line, location.col, location.offset);
+        error_message.resize(count);
+    } else {
+        error_message.clear();
+    }
+
+    longjmp(parse_error_handler, 1);
+}
+
+void yaml::initialize()
+{
+    // callbacks are shared by all threads, and registered once
+    static const bool registered = (ryml::set_callbacks(ryml::Callbacks(nullptr, &parser_allocate, &parser_free, &parser_raise)), true);
+    (void)registered;
+
+    // parser state allocates with the callbacks current at the time of construction
+    if (!context) {
+        context.reset(new ParseContext());
+        context->parser.reserve_stack(parser_stack_capacity);
+    }
+}
+
+bool yaml::guard(void (*fn)(void*), void* data)
+{
+    if (setjmp(parse_error_handler)) {
+        return false;
+    }
+    fn(data);
+    return true;
+}
+
+const std::string& yaml::error_message()
+{
+    return ::error_message;
+}
+
+const std::string& yaml::invalid_utf8(std::size_t pos)
+{
+    constexpr const char* fmt = "invalid UTF-8 character in JSON at offset %zu";
+    int count = std::snprintf(nullptr, 0, fmt, pos);
+    if (count >= 0) {
+        ::error_message.resize(count + 1);
+        std::snprintf(::error_message.data(), ::error_message.size(), fmt, pos);
+        ::error_message.resize(count);
+    } else {
+        ::error_message.clear();
+    }
+    return ::error_message;
+}
+
+const std::string& yaml::set_error_message(const std::string& message)
+{
+    ::error_message = message;
+    return ::error_message;
+}
+
+const yaml::Statistics& yaml::statistics()
+{
+    return ::statistics;
+}
+
+yaml::Estimate yaml::estimate(const char* str, std::size_t len)
+{
+    // most nodes start on a new line (block style) or after a separator (flow style), and an item of a block
+    // sequence that is a mapping (`- key: value`) contributes an extra node
+    std::size_t lines = 0;
+    std::size_t separators = 0;
+    std::size_t dashes = 0;
+    // the arena is only needed when a filtered scalar is longer than its source, e.g. with some escape sequences
+    // (as in `\L`) or with keep chomping in block scalars
+    std::size_t escapes = 0;
+    std::size_t blocks = 0;
+
+    const char* p = str;
+    const char* end = str + len;
+#if SIMD_WIDTH > 0
+    const simd::bytes newline = simd::splat('\n');
+    const simd::bytes comma = simd::splat(',');
+    const simd::bytes bracket = simd::splat('[');
+    const simd::bytes brace = simd::splat('{');
+    const simd::bytes dash = simd::splat('-');
+    const simd::bytes backslash = simd::splat('\\');
+    const simd::bytes literal = simd::splat('|');
+    const simd::bytes folded = simd::splat('>');
+    while (end - p >= SIMD_WIDTH) {
+        simd::bytes v = simd::load(p);
+        lines += __builtin_popcount(simd::bitmask(simd::eq(v, newline)));
+        separators += __builtin_popcount(simd::bitmask(simd::bit_or(simd::eq(v, comma), simd::bit_or(simd::eq(v, bracket), simd::eq(v, brace)))));
+        dashes += __builtin_popcount(simd::bitmask(simd::eq(v, dash)));
+        escapes += __builtin_popcount(simd::bitmask(simd::eq(v, backslash)));
+        blocks += __builtin_popcount(simd::bitmask(simd::bit_or(simd::eq(v, literal), simd::eq(v, folded))));
+        p += SIMD_WIDTH;
+    }
+#endif
+    for (; p != end; ++p) {
+        switch (*p) {
+        case '\n':
+            ++lines;
+            break;
+        case ',':
+        case '[':
+        case '{':
+            ++separators;
+            break;
+        case '-':
+            ++dashes;
+            break;
+        case '\\':
+            ++escapes;
+            break;
+        case '|':
+        case '>':
+            ++blocks;
+            break;
+        }
+    }
+
+    // root and document nodes, plus the last line without a line break
+    std::size_t nodes = lines + separators + dashes + 3;
+    return { static_cast<ryml::id_type>(nodes), escapes + 16 * blocks };
+}
+
+ryml::Tree& yaml::parse(char* str, const Options& options)
+{
+    ParseContext& context = thread_context();
+    ryml::Tree& tree = context.tree;
+    if (tree.capacity() > yaml::retained_node_capacity) {
+        tree = ryml::Tree();
+    } else {
+        tree.clear();
+        tree.clear_arena();
+    }
+
+    std::size_t len = std::strlen(str);
+    if (len > options.max_input_bytes) {
+        constexpr const char* msg = "max input bytes exceeded";
+        parser_raise(msg, std::strlen(msg), ryml::Location(std::size_t(0), std::size_t(0), std::size_t(0)), nullptr);
+    }
+    // a matcher usually stops parsing early, such that sizing the tree for the entire document would be wasted
+    if (!context.event_handler.matcher) {
+        Estimate sizing = estimate(str, len);
+        if (sizing.nodes > options.max_nodes) {
+            sizing.nodes = options.max_nodes;
+        }
+        tree.reserve(sizing.nodes);
+        if (sizing.arena > 0) {
+            tree.reserve_arena(sizing.arena);
+        }
+    }
+
+    ryml::id_type node_capacity = tree.capacity();
+    std::size_t arena_capacity = tree.arena_capacity();
+    context.event_handler.max_nodes = options.max_nodes;
+    context.event_handler.reset(&tree, tree.root_id());
+    context.parser.parse_in_place_ev({}, ryml::substr(str, len));
+    if (tree.capacity() > node_capacity) {
+        ++::statistics.node_regrowths;
+    }
+    if (tree.arena_capacity() > arena_capacity) {
+        ++::statistics.arena_regrowths;
+    }
+    return tree;
+}
+
+namespace
+{
+    /** Arguments of a function that parses YAML and writes its representation in some format. */
+    struct Conversion
+    {
+        char* str;
+        std::string* out;
+        const yaml::Options* options;
+        void (*emit)(const ryml::Tree&, std::string&, const json::EmitOptions&);
+    };
+}
+
+static void parse_and_emit(void* data)
+{
+    Conversion* args = static_cast<Conversion*>(data);
+    args->emit(yaml::parse(args->str, *args->options), *args->out, args->options->emit);
+}
+
+bool yaml::to_json(char* str, std::string& json, const Options& options)
+{
+    Conversion args = { str, &json, &options, &json::emit };
+    return guard(&parse_and_emit, &args);
+}
+
+bool yaml::to_tape(char* str, std::string& tape, const Options& options)
+{
+    Conversion args = { str, &tape, &options, &tape::emit };
+    return guard(&parse_and_emit, &args);
+}
+
+namespace
+{
+    /** Arguments of a function that parses YAML into a tree kept by the caller. */
+    struct TreeConversion
+    {
+        char* str;
+        ryml::Tree* tree;
+        const yaml::Options* options;
+    };
+}
+
+static void parse_and_keep(void* data)
+{
+    TreeConversion* args = static_cast<TreeConversion*>(data);
+    *args->tree = std::move(yaml::parse(args->str, *args->options));
+}
+
+bool yaml::to_tree(char* str, ryml::Tree& tree, const Options& options)
+{
+    TreeConversion args = { str, &tree, &options };
+    return guard(&parse_and_keep, &args);
+}
+
+/** Decides whether a document matches, reused across calls. */
+static thread_local Matcher matcher;
+
+namespace
+{
+    /** Arguments of a function that parses YAML until it finds whether the value at a path equals a scalar. */
+    struct Containment
+    {
+        char* str;
+        const yaml::Options* options;
+    };
+}
+
+static void parse_and_match(void* data)
+{
+    Containment* args = static_cast<Containment*>(data);
+    const ryml::Tree& tree = yaml::parse(args->str, *args->options);
+    if (!matcher.decided) {
+        // the path is at the end of the document, or refers to the root
+        ryml::id_type root = tree.root_id();
+        matcher.decide(!tree.is_stream(root) && matcher.equals(tree, root, 0));
+    }
+}
+
+bool yaml::contains(char* str, const std::vector<path::Segment>& segments, ryml::csubstr value, bool& found, const Options& options)
+{
+    matcher.reset(segments, value, 0);
+    ParseContext& context = thread_context();
+    context.event_handler.matcher = &matcher;
+    Containment args = { str, &options };
+    guard(&parse_and_match, &args);
+    context.event_handler.matcher = nullptr;
+
+    // parsing stops early (as if an error has occurred) once a decision is reached, and a decision is always reached
+    // unless the document is malformed
+    if (!matcher.decided) {
+        return false;
+    }
+    found = matcher.found;
+    return true;
+}
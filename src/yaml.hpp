@@ -0,0 +1,129 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+#pragma once
+#include "ryml_all.hpp"
+#include "json.hpp"
+#include "path.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace yaml
+{
+    /** Trees that grow beyond this number of nodes are released after use rather than kept for the next call. */
+    constexpr ryml::id_type retained_node_capacity = 1 << 16;
+
+    /** Counts how often storage had to be enlarged while parsing. */
+    struct Statistics
+    {
+        /** Number of parses during which the node array of the tree was reallocated. */
+        std::size_t node_regrowths = 0;
+        /** Number of parses during which the string arena of the tree was reallocated. */
+        std::size_t arena_regrowths = 0;
+    };
+
+    /**
+     * Per-document settings.
+     *
+     * Resource budgets turn pathological input into an error rather than a stalled batch.
+     */
+    struct Options
+    {
+        /** Maximum length of the YAML string in bytes. */
+        std::size_t max_input_bytes = SIZE_MAX;
+        /** Maximum number of nodes in the YAML tree. */
+        ryml::id_type max_nodes = ryml::NONE;
+        /** Settings of the JSON output. */
+        json::EmitOptions emit;
+    };
+
+    /** Sizing of a tree needed to parse a YAML string, estimated by a quick scan. */
+    struct Estimate
+    {
+        ryml::id_type nodes;
+        std::size_t arena;
+    };
+
+    /** Estimates the number of nodes and the arena size required to parse a YAML string. */
+    Estimate estimate(const char* str, std::size_t len);
+
+    /**
+     * Registers memory allocation and error callbacks with Rapid YAML (once per process), and sets up parser state for
+     * the calling thread. Must be called at startup, before any tree is created; other threads set up their parser
+     * state on first use.
+     */
+    void initialize();
+
+    /**
+     * Runs a function that may trigger a parse error.
+     *
+     * Errors raised by Rapid YAML jump back to this function with `longjmp`. This is the only function that calls
+     * `setjmp`, and it makes a single call, which keeps the cost of Emscripten `setjmp`/`longjmp` emulation (which
+     * instruments every call made by a function that calls `setjmp`) constant per row.
+     *
+     * @returns False if an error has been raised; see `error_message`.
+     */
+    bool guard(void (*fn)(void*), void* data);
+
+    /** Describes the last error raised. */
+    const std::string& error_message();
+
+    /** Records (and describes) an invalid UTF-8 character in JSON output as the last error. */
+    const std::string& invalid_utf8(std::size_t pos);
+
+    /** Records an error as the last error of the calling thread (e.g. an error raised on another thread on its behalf). */
+    const std::string& set_error_message(const std::string& message);
+
+    /** Reports how often storage had to be enlarged while parsing. */
+    const Statistics& statistics();
+
+    /**
+     * Parses a YAML string in place into a tree that is reused across calls.
+     *
+     * Tree storage is reserved up front based on `estimate` to avoid reallocating nodes mid-parse. Input length and
+     * node count are checked against `options` (the latter as nodes are created).
+     * Must be called (directly or indirectly) from a function passed to `guard`.
+     */
+    ryml::Tree& parse(char* str, const Options& options = Options());
+
+    /**
+     * Parses a YAML string in place, and appends its JSON representation to a buffer.
+     *
+     * @returns False if the YAML string is malformed, or exceeds any of the budgets in `options`; see `error_message`.
+     */
+    bool to_json(char* str, std::string& json, const Options& options = Options());
+
+    /**
+     * Parses a YAML string in place, and appends its tape representation (see `tape::emit`) to a buffer.
+     *
+     * @returns False if the YAML string is malformed, or exceeds any of the budgets in `options`; see `error_message`.
+     */
+    bool to_tape(char* str, std::string& tape, const Options& options = Options());
+
+    /**
+     * Parses a YAML string in place, and moves the resulting tree into `tree` (releasing its previous storage).
+     *
+     * Nodes of the tree refer to the YAML string, which must outlive the tree.
+     * @returns False if the YAML string is malformed, or exceeds any of the budgets in `options`; see `error_message`.
+     */
+    bool to_tree(char* str, ryml::Tree& tree, const Options& options = Options());
+
+    /**
+     * Parses a YAML string in place until it is decided whether the node at a path is a scalar equal to `value`.
+     *
+     * Parsing stops as soon as the part of the document that holds the path has been parsed, without building JSON.
+     * The rest of the document is not checked: it may be malformed (or exceed budgets) without affecting the result.
+     * Scalars are compared as text (e.g. `8080` matches `8080` and `'8080'`), after quotes and escapes are resolved.
+     *
+     * @param found Set to whether the node at the path equals the value.
+     * @returns False if the YAML string is malformed before a decision is reached, or exceeds any of the budgets in
+     * `options`; see `error_message`.
+     */
+    bool contains(char* str, const std::vector<path::Segment>& segments, ryml::csubstr value, bool& found, const Options& options = Options());
+}
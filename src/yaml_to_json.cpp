@@ -6,66 +6,612 @@
  * @see https://github.com/hunyadi/yaml-to-json
 **/
 
-#include "ryml_all.hpp"
+#include "cache.hpp"
+#include "columns.hpp"
+#include "convert.hpp"
+#include "document.hpp"
+#include "json.hpp"
+#include "path.hpp"
+#include "schema.hpp"
+#include "split.hpp"
 #include "string.hpp"
 #include "utf8.hpp"
-#include <csetjmp>
+#include "yaml.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
 
-static std::jmp_buf parse_error_handler;
+// state other than settings is kept per thread, such that threads of a native host may convert documents in parallel
+static thread_local ResultCache result_cache;
+static thread_local DocumentTable documents;
+static thread_local std::size_t row_count = 0;
+static thread_local std::size_t json_fast_path_count = 0;
+static yaml::Options options;
 
-static void* parser_allocate(size_t len, void* hint, void* user_data)
+/** Identifies a setting that tunes the behavior of the conversion function. */
+enum Option
 {
-    return std::malloc(len);
+    /** Maximum number of bytes the result cache may consume (zero turns off caching). */
+    OPTION_CACHE_CAPACITY = 1,
+    /** Maximum nesting depth of documents (deeper documents convert to NULL). */
+    OPTION_MAX_DEPTH = 2,
+    /** Maximum length of YAML input in bytes (zero for no limit; longer documents convert to NULL). */
+    OPTION_MAX_INPUT_BYTES = 3,
+    /** Maximum number of nodes in a YAML document (zero for no limit; larger documents convert to NULL). */
+    OPTION_MAX_NODES = 4,
+    /** Maximum length of JSON output in bytes (zero for no limit; longer results convert to NULL). */
+    OPTION_MAX_OUTPUT_BYTES = 5,
+    /** Whether to replace aliases and merge keys with what they refer to (non-zero) or write aliases as strings (zero). */
+    OPTION_EXPAND_ALIASES = 6,
+    /** Maximum number of bytes written on behalf of aliases and merge keys (zero for no limit; larger expansions convert to NULL). */
+    OPTION_MAX_EXPANSION_BYTES = 7
+};
+
+/** Identifies a counter that reports on the operation of the conversion function. */
+enum Statistic
+{
+    STATISTIC_CACHE_HITS = 1,
+    STATISTIC_CACHE_MISSES = 2,
+    STATISTIC_CACHE_EVICTIONS = 3,
+    STATISTIC_CACHE_ENTRIES = 4,
+    STATISTIC_CACHE_BYTES = 5,
+    STATISTIC_ROWS = 6,
+    STATISTIC_JSON_FAST_PATH = 7,
+    STATISTIC_NODE_REGROWTHS = 8,
+    STATISTIC_ARENA_REGROWTHS = 9,
+    STATISTIC_OPEN_DOCUMENTS = 10
+};
+
+extern "C"
+{
+    /** Converts a YAML string into a JSON string. */
+    String* transform_yaml(String* in_str);
+
+    /**
+     * Converts a YAML string into a JSON string, or describes why conversion has failed.
+     *
+     * The first character of the result is a tag: `J` is followed by a JSON string, and `E` by an error message
+     * (as reported by `check_yaml`).
+     */
+    String* transform_yaml_or_error(String* in_str);
+
+    /** Converts a YAML string into a tape, which JavaScript turns into objects without parsing JSON text. */
+    String* transform_yaml_tape(String* in_str);
+
+    /**
+     * Checks if the node at a path (see `path::parse`) of a YAML document is a scalar equal to a value.
+     *
+     * Parsing stops as soon as the result is known.
+     * @returns 1 if the value is found, 0 if not, or -1 if the document is malformed (or the path is invalid).
+     */
+    int yaml_contains(String* in_str, String* path, String* value);
+
+    /**
+     * Parses a YAML string, and keeps it in memory for lookups by path (see `DocumentTable`).
+     *
+     * Takes ownership of the input string.
+     * @returns A handle to pass to other `doc_` functions, or zero if the document cannot be opened.
+     */
+    std::uint32_t doc_open(String* in_str);
+
+    /** Converts the node at a path of an open document into a JSON string, or returns null if there is no such node. */
+    String* doc_get(std::uint32_t handle, String* path);
+
+    /** Returns the JSON value type (see `DocumentType`) of the node at a path of an open document. */
+    int doc_type(std::uint32_t handle, String* path);
+
+    /** Returns the number of items (or entries) of the array (or object) at a path of an open document, or -1. */
+    int doc_len(std::uint32_t handle, String* path);
+
+    /** Releases an open document. */
+    void doc_close(std::uint32_t handle);
+
+    /**
+     * Compiles paths (see `path::parse`) separated by NUL characters into a column set (see `ColumnSet`), to be
+     * released with `columns_delete`.
+     * @returns The column set, or null if a path is malformed.
+     */
+    ColumnSet* columns_compile(String* paths);
+
+    /**
+     * Parses a YAML string, and appends a row with the JSON value at each path of a column set.
+     * @returns False if the document is malformed (in which case all cells of the row are missing).
+     */
+    bool transform_yaml_columns(String* in_str, ColumnSet* columns);
+
+    /** Returns the rows appended to a column set since the last call (see `ColumnSet::write`), and starts a new batch. */
+    String* columns_result(ColumnSet* columns);
+
+    /** Releases a column set. */
+    void columns_delete(ColumnSet* columns);
+
+    /** Creates an empty schema aggregate (see `Schema`), to be released with `schema_delete`. */
+    Schema* schema_begin();
+
+    /**
+     * Parses a YAML string, and records the paths and value types of the document in a schema aggregate.
+     * @returns False if the document is malformed (which is counted as an error in the aggregate).
+     */
+    bool schema_add(Schema* schema, String* in_str);
+
+    /** Adds the counts of a schema aggregate to another. */
+    void schema_merge(Schema* schema, Schema* other);
+
+    /** Writes a schema aggregate as a JSON object (see `Schema::write`). */
+    String* schema_result(Schema* schema);
+
+    /** Releases a schema aggregate. */
+    void schema_delete(Schema* schema);
+
+    /**
+     * Converts a column of YAML strings into a column of JSON strings, both in the memory layout of an Apache Arrow
+     * `StringArray`, without allocating memory for each row.
+     *
+     * @param offsets `n + 1` offsets into `data`, such that row `i` spans bytes `offsets[i]` to `offsets[i + 1]`.
+     * @param data UTF-8 bytes of all rows.
+     * @param n Number of rows.
+     * @param validity Validity bitmap (bit `i % 8` of byte `i / 8` is set if row `i` is not null), or null if no row
+     * is null.
+     * @param out_offsets Receives `n + 1` offsets into the output data, starting at zero.
+     * @param out_data Receives a pointer to the output data, which is owned by the library, and remains valid until the
+     * next call.
+     * @param out_validity Receives the validity bitmap of the output (`(n + 7) / 8` bytes); rows that are null or fail
+     * to convert are null.
+     * @returns Number of bytes of output data, or -1 if the output exceeds the range of 32-bit offsets.
+     */
+    std::int64_t transform_yaml_arrow(const std::int32_t* offsets, const char* data, std::int64_t n, const std::uint8_t* validity, std::int32_t* out_offsets, const char** out_data, std::uint8_t* out_validity);
+
+    /**
+     * Changes a setting of the conversion function.
+     *
+     * Settings are shared by all threads without synchronization, and must not change while other threads convert
+     * documents, except for `OPTION_CACHE_CAPACITY`, which changes the result cache of the calling thread only.
+     */
+    bool transform_configure(int option, std::size_t value);
+
+    /** Returns the current value of a counter. */
+    std::size_t transform_statistic(int statistic);
 }
 
-static void parser_free(void* mem, size_t size, void* user_data)
+/** Tag of a result of `transform_yaml_or_error` that holds a JSON string. */
+constexpr char tag_json = 'J';
+/** Tag of a result of `transform_yaml_or_error` that holds an error message. */
+constexpr char tag_error = 'E';
+
+/** Skips the start of document marker (`---`) at the beginning of a YAML string of `size` bytes, if any. */
+static char* skip_document_start(char* str, std::size_t size)
 {
-    std::free(mem);
+    if (size > 3 && str[0] == '-' && str[1] == '-' && str[2] == '-') {
+        return str + 3;
+    }
+    return str;
 }
 
-static void parser_raise(const char* msg, size_t msg_len, ryml::Location location, void* user_data)
+/**
+ * Converts a NUL-terminated YAML string of `size` bytes (which is modified in place) into a JSON string, bypassing the
+ * result cache, with large top-level sequences split across a number of threads.
+ * @returns False if conversion has failed; see `yaml::error_message`.
+ */
+static bool convert_yaml(char* str, std::size_t size, std::string& json, std::size_t threads = 1)
 {
-    longjmp(parse_error_handler, 1);
+    char* s = skip_document_start(str, size);
+
+    // a YAML tree may take one more node than the number of JSON values (e.g. `[]` takes two); inputs close to the
+    // limit fall back to parsing as YAML, which counts nodes exactly
+    ryml::id_type max_values = options.max_nodes != ryml::NONE ? options.max_nodes - 1 : ryml::NONE;
+
+    std::size_t len = size - (s - str);
+    if (len <= options.max_input_bytes && json::looks_like_json(s, len) && json::minify(s, len, json, options.emit.max_depth, max_values) && json.size() <= options.emit.max_output_bytes) {
+        // input is already JSON, skip building a YAML tree
+        ++json_fast_path_count;
+    } else {
+        json.clear();
+        if (!(threads > 1 ? split::to_json(s, json, options, threads) : yaml::to_json(s, json, options))) {
+            return false;
+        }
+    }
+
+    // check if string is valid UTF-8
+    std::size_t pos;
+    if (!utf8::is_valid(json.data(), json.size(), pos, threads)) {
+        yaml::invalid_utf8(pos);
+        return false;
+    }
+    return true;
 }
 
-extern "C"
+/** Converts a YAML string into a JSON string, bypassing the result cache. */
+static bool convert_yaml(String* in_str, std::string& json)
 {
-    /** Converts a YAML string into a JSON string. */
-    String* transform_yaml(String* in_str);
+    return convert_yaml(in_str->data(), in_str->size(), json);
+}
+
+/** Converts a YAML string into a JSON string, bypassing the result cache. */
+static String* convert_yaml(String* in_str)
+{
+    std::string json;
+    if (!convert_yaml(in_str, json)) {
+        return nullptr;
+    }
+    return new String(json.data(), json.size());
 }
 
 /** Converts a YAML string into a JSON string. */
 String* transform_yaml(String* in_str)
 {
-    char* s = in_str->data();
+    ++row_count;
+    if (in_str->size() > options.max_input_bytes) {
+        // reject before hashing and copying input
+        return nullptr;
+    }
+    if (!result_cache.enabled()) {
+        return convert_yaml(in_str);
+    }
+
+    std::uint64_t hash = hash_bytes(in_str->data(), in_str->size());
+    String* result;
+    if (result_cache.find(in_str->data(), in_str->size(), hash, result)) {
+        return result;
+    }
+
+    // save input because parsing modifies the string in place
+    std::string key(in_str->data(), in_str->size());
+    result = convert_yaml(in_str);
+    result_cache.insert(hash, std::move(key), result);
+    return result;
+}
+
+/** Creates a result of `transform_yaml_or_error`. */
+static String* tagged(char tag, const char* data, std::size_t len)
+{
+    String* result = new String(len + 1);
+    (*result)[0] = tag;
+    std::memcpy(result->data() + 1, data, len);
+    return result;
+}
+
+/** Converts a YAML string into a JSON string, or describes why conversion has failed. */
+String* transform_yaml_or_error(String* in_str)
+{
+    ++row_count;
+    bool cacheable = result_cache.enabled() && in_str->size() <= options.max_input_bytes;
+    std::uint64_t hash = 0;
+    bool cached = false;
+    if (cacheable) {
+        // only successful conversions are answered from the cache, failed ones are parsed again to find the reason
+        hash = hash_bytes(in_str->data(), in_str->size());
+        String* result = nullptr;
+        cached = result_cache.find(in_str->data(), in_str->size(), hash, result);
+        if (result) {
+            String* json = tagged(tag_json, result->data(), result->size());
+            delete result;
+            return json;
+        }
+    }
+
+    // save input because parsing modifies the string in place
+    std::string key;
+    if (cacheable && !cached) {
+        key.assign(in_str->data(), in_str->size());
+    }
+
+    std::string json;
+    bool success = convert_yaml(in_str, json);
+    if (cacheable && !cached) {
+        String* result = success ? new String(json.data(), json.size()) : nullptr;
+        result_cache.insert(hash, std::move(key), result);
+        delete result;
+    }
+    if (success) {
+        return tagged(tag_json, json.data(), json.size());
+    } else {
+        const std::string& error_message = yaml::error_message();
+        return tagged(tag_error, error_message.data(), error_message.size());
+    }
+}
 
-    // skip start of document marker
-    if (in_str->size() > 3 && s[0] == '-' && s[1] == '-' && s[2] == '-') {
-        s += 3;
+/** Converts a YAML string into a tape, which JavaScript turns into objects without parsing JSON text. */
+String* transform_yaml_tape(String* in_str)
+{
+    ++row_count;
+    if (in_str->size() > options.max_input_bytes) {
+        return nullptr;
     }
 
-    if (setjmp(parse_error_handler)) {
+    char* s = skip_document_start(in_str->data(), in_str->size());
+
+    std::string tape;
+    if (!yaml::to_tape(s, tape, options)) {
         return nullptr;
     }
 
-    // parse YAML
-    ryml::Tree tree = ryml::parse_in_place(s);
+    // check if the string pool (which follows the entries) is valid UTF-8; unlike JSON text, the pool holds NUL
+    // characters unescaped, which the validator stops at
+    std::uint32_t count = 0;
+    if (!tape.empty()) {
+        std::memcpy(&count, tape.data(), sizeof(count));
+    }
+    std::size_t pool_offset = tape.empty() ? 0 : sizeof(std::uint32_t) * (count + 1);
+    const char* pool = tape.data() + pool_offset;
+    std::size_t remaining = tape.size() - pool_offset;
+    std::size_t pos;
+    while (!utf8::is_valid(pool, remaining, pos)) {
+        if (pool[pos] != '\0') {
+            return nullptr;
+        }
+        pool += pos + 1;
+        remaining -= pos + 1;
+    }
+
+    return new String(tape.data(), tape.size());
+}
+
+/** Segments of the path passed to `yaml_contains`, reused across calls. */
+static thread_local std::vector<path::Segment> contains_segments;
+
+/** Checks if the node at a path of a YAML document is a scalar equal to a value. */
+int yaml_contains(String* in_str, String* path, String* value)
+{
+    ++row_count;
+    if (in_str->size() > options.max_input_bytes || !path::parse(path->data(), path->size(), contains_segments)) {
+        return -1;
+    }
+
+    char* s = skip_document_start(in_str->data(), in_str->size());
+
+    bool found;
+    if (!yaml::contains(s, contains_segments, ryml::csubstr(value->data(), value->size()), found, options)) {
+        return -1;
+    }
+    return found ? 1 : 0;
+}
+
+/** Parses a YAML string, and keeps it in memory for lookups by path. */
+std::uint32_t doc_open(String* in_str)
+{
+    ++row_count;
+    if (in_str->size() > options.max_input_bytes) {
+        delete in_str;
+        return 0;
+    }
+
+    char* s = skip_document_start(in_str->data(), in_str->size());
+
+    return documents.open(in_str, s, options);
+}
+
+/** Converts the node at a path of an open document into a JSON string. */
+String* doc_get(std::uint32_t handle, String* path)
+{
+    ryml::id_type node;
+    const ryml::Tree* tree = documents.find(handle, path->data(), path->size(), node);
+    if (!tree) {
+        return nullptr;
+    }
 
-    // emit JSON
-    std::string json = ryml::emitrs_json<std::string>(tree);
+    std::string json;
+    if (!document_to_json(*tree, node, json, options.emit)) {
+        return nullptr;
+    }
 
     // check if string is valid UTF-8
     std::size_t pos;
     if (!utf8::is_valid(json, pos)) {
         return nullptr;
     }
+    return new String(json.data(), json.size());
+}
 
-    // construct result
+/** Returns the JSON value type of the node at a path of an open document. */
+int doc_type(std::uint32_t handle, String* path)
+{
+    ryml::id_type node;
+    const ryml::Tree* tree = documents.find(handle, path->data(), path->size(), node);
+    if (!tree) {
+        return static_cast<int>(DocumentType::missing);
+    }
+    return static_cast<int>(document_type(*tree, node));
+}
+
+/** Returns the number of items (or entries) of the array (or object) at a path of an open document. */
+int doc_len(std::uint32_t handle, String* path)
+{
+    ryml::id_type node;
+    const ryml::Tree* tree = documents.find(handle, path->data(), path->size(), node);
+    if (!tree || !tree->is_container(node)) {
+        return -1;
+    }
+    return static_cast<int>(tree->num_children(node));
+}
+
+/** Releases an open document. */
+void doc_close(std::uint32_t handle)
+{
+    documents.close(handle);
+}
+
+/** Compiles paths into a column set. */
+ColumnSet* columns_compile(String* paths)
+{
+    ColumnSet* columns = new ColumnSet();
+    if (!columns->compile(paths->data(), paths->size())) {
+        delete columns;
+        return nullptr;
+    }
+    return columns;
+}
+
+/** Appends a row with the JSON value at each path of a column set. */
+bool transform_yaml_columns(String* in_str, ColumnSet* columns)
+{
+    ++row_count;
+    char* s = skip_document_start(in_str->data(), in_str->size());
+
+    return columns->add(s, options);
+}
+
+/** Returns the rows appended to a column set, and starts a new batch. */
+String* columns_result(ColumnSet* columns)
+{
+    std::string result;
+    columns->write(result);
+    return new String(result.data(), result.size());
+}
+
+/** Releases a column set. */
+void columns_delete(ColumnSet* columns)
+{
+    delete columns;
+}
+
+/** Creates an empty schema aggregate. */
+Schema* schema_begin()
+{
+    return new Schema();
+}
+
+/** Records the paths and value types of a YAML document in a schema aggregate. */
+bool schema_add(Schema* schema, String* in_str)
+{
+    ++row_count;
+    char* s = skip_document_start(in_str->data(), in_str->size());
+
+    // input longer than the limit fails to parse, and is counted as an error
+    return schema->add(s, options);
+}
+
+/** Adds the counts of a schema aggregate to another. */
+void schema_merge(Schema* schema, Schema* other)
+{
+    schema->merge(*other);
+}
+
+/** Writes a schema aggregate as a JSON object. */
+String* schema_result(Schema* schema)
+{
+    std::string json;
+    schema->write(json);
     return new String(json.data(), json.size());
 }
 
+/** Releases a schema aggregate. */
+void schema_delete(Schema* schema)
+{
+    delete schema;
+}
+
+/** A row copied for parsing in place, the JSON string of a row, and the output of the last call to `transform_yaml_arrow`. */
+static thread_local std::string arrow_row;
+static thread_local std::string arrow_json;
+static thread_local std::string arrow_output;
+
+/** Converts a column of YAML strings into a column of JSON strings in the memory layout of Apache Arrow. */
+std::int64_t transform_yaml_arrow(const std::int32_t* offsets, const char* data, std::int64_t n, const std::uint8_t* validity, std::int32_t* out_offsets, const char** out_data, std::uint8_t* out_validity)
+{
+    // the native library has no `main` to set up the parser
+    yaml::initialize();
+
+    // buffers keep their capacity across rows and calls, so rows are converted without allocating memory
+    arrow_output.clear();
+    std::memset(out_validity, 0, static_cast<std::size_t>((n + 7) / 8));
+    out_offsets[0] = 0;
+    for (std::int64_t i = 0; i < n; ++i) {
+        ++row_count;
+        if (!validity || (validity[i / 8] >> (i % 8)) & 1) {
+            arrow_row.assign(data + offsets[i], offsets[i + 1] - offsets[i]);
+            arrow_json.clear();
+            if (convert_yaml(&arrow_row[0], arrow_row.size(), arrow_json)) {
+                arrow_output += arrow_json;
+                out_validity[i / 8] |= static_cast<std::uint8_t>(1 << (i % 8));
+            }
+        }
+        if (arrow_output.size() > INT32_MAX) {
+            return -1;
+        }
+        out_offsets[i + 1] = static_cast<std::int32_t>(arrow_output.size());
+    }
+
+    *out_data = arrow_output.data();
+    return static_cast<std::int64_t>(arrow_output.size());
+}
+
+/** Converts a YAML string in place into a JSON string. */
+bool transform_yaml_in_place(char* str, std::size_t size, std::string& json, std::size_t threads)
+{
+    ++row_count;
+    json.clear();
+    return convert_yaml(str, size, json, threads);
+}
+
+/** Changes a setting of the conversion function. */
+bool transform_configure(int option, std::size_t value)
+{
+    switch (option) {
+    case OPTION_CACHE_CAPACITY:
+        result_cache.set_capacity(value);
+        return true;
+    case OPTION_MAX_DEPTH:
+        options.emit.max_depth = static_cast<ryml::id_type>(value);
+        break;
+    case OPTION_MAX_INPUT_BYTES:
+        options.max_input_bytes = value ? value : SIZE_MAX;
+        break;
+    case OPTION_MAX_NODES:
+        options.max_nodes = value ? static_cast<ryml::id_type>(value) : ryml::NONE;
+        break;
+    case OPTION_MAX_OUTPUT_BYTES:
+        options.emit.max_output_bytes = value ? value : SIZE_MAX;
+        break;
+    case OPTION_EXPAND_ALIASES:
+        options.emit.expand_aliases = value != 0;
+        break;
+    case OPTION_MAX_EXPANSION_BYTES:
+        options.emit.max_expansion_bytes = value ? value : SIZE_MAX;
+        break;
+    default:
+        return false;
+    }
+
+    // cached results may have been produced with different settings
+    result_cache.clear();
+    return true;
+}
+
+/** Returns the current value of a counter. */
+std::size_t transform_statistic(int statistic)
+{
+    switch (statistic) {
+    case STATISTIC_CACHE_HITS:
+        return result_cache.hits();
+    case STATISTIC_CACHE_MISSES:
+        return result_cache.misses();
+    case STATISTIC_CACHE_EVICTIONS:
+        return result_cache.evictions();
+    case STATISTIC_CACHE_ENTRIES:
+        return result_cache.entries();
+    case STATISTIC_CACHE_BYTES:
+        return result_cache.bytes();
+    case STATISTIC_ROWS:
+        return row_count;
+    case STATISTIC_JSON_FAST_PATH:
+        return json_fast_path_count;
+    case STATISTIC_NODE_REGROWTHS:
+        return yaml::statistics().node_regrowths;
+    case STATISTIC_ARENA_REGROWTHS:
+        return yaml::statistics().arena_regrowths;
+    case STATISTIC_OPEN_DOCUMENTS:
+        return documents.size();
+    default:
+        return 0;
+    }
+}
+
+#ifdef __EMSCRIPTEN__
+// native builds set up the parser on first use, and command-line tools have a `main` of their own
 int main(int argc, const char* argv[])
 {
-    ryml::set_callbacks(ryml::Callbacks(nullptr, &parser_allocate, &parser_free, &parser_raise));
+    yaml::initialize();
     return 0;
 }
+#endif
@@ -0,0 +1,380 @@
+/**
+ * Convert YAML to JSON with Wasm
+ *
+ * Copyright 2024, Levente Hunyadi
+ *
+ * @see https://github.com/hunyadi/yaml-to-json
+**/
+
+// unit tests of native builds, for functions that `test.js` cannot reach through the Wasm build (e.g. conversion on
+// several threads) and for the command-line converter `dist/yaml_to_json`; run with `make test-native` (POSIX only)
+
+#include "json.hpp"
+#include "split.hpp"
+#include "utf8.hpp"
+#include "yaml.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+extern "C"
+{
+    std::int64_t transform_yaml_arrow(const std::int32_t* offsets, const char* data, std::int64_t n, const std::uint8_t* validity, std::int32_t* out_offsets, const char** out_data, std::uint8_t* out_validity);
+}
+
+/** Reports a failed assertion and exits (assertions are checked even if `NDEBUG` is defined). */
+#define check(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while (false)
+
+/** Number of threads that convert in parallel in tests, regardless of the number of cores. */
+constexpr std::size_t test_threads = 8;
+
+/** Converts a copy of a YAML string with `split::to_json`, and returns the JSON string, or the error message. */
+static std::string split_to_json(const std::string& yaml, std::size_t threads, const yaml::Options& options = yaml::Options())
+{
+    std::string copy(yaml);
+    std::string json;
+    if (!split::to_json(copy.data(), json, options, threads)) {
+        return "error: " + yaml::error_message();
+    }
+    return json;
+}
+
+/** Builds a top-level block sequence of at least `size` bytes, with items of several kinds. */
+static std::string make_sequence(std::size_t size)
+{
+    std::string yaml = "# leading comment\n- &first {anchor: 1}\n";
+    for (std::size_t i = 0; yaml.size() < size; ++i) {
+        std::string n = std::to_string(i);
+        switch (i % 4) {
+        case 0:
+            yaml += "- [" + n + ", \"two\", {a: b}]\n";
+            break;
+        case 1:
+            yaml += "- text: |\n    - not an item " + n + "\n    - neither this\n  n: " + n + "\n";
+            break;
+        case 2:
+            yaml += "- key: 'quoted # " + n + "'\n  list:\n  - " + n + "\n  - x\n";
+            break;
+        default:
+            yaml += "- " + n + "\n";
+            break;
+        }
+    }
+    yaml += "- *first\n";
+    return yaml;
+}
+
+// chunks of a large top-level sequence convert to the same bytes as the sequence as a whole
+static void test_split_to_json()
+{
+    std::string yaml = make_sequence(split::min_document_bytes + (1 << 20));
+    std::vector<std::size_t> items;
+    check(split::find_items(yaml.data(), yaml.size(), false, items));
+
+    std::string serial = split_to_json(yaml, 1);
+    check(serial.size() > 2 && serial.front() == '[');
+    check(serial.find("{\"anchor\": 1}") != std::string::npos);
+    check(serial.find("- not an item 1") != std::string::npos);
+    check(split_to_json(yaml, test_threads) == serial);
+
+    // an error in a late chunk is reported at the same location as without chunks
+    std::string malformed = yaml;
+    malformed.insert(malformed.size() - 4096 + malformed.substr(malformed.size() - 4096).find("\n- ") + 1, "- a: b\n   c: d\n");
+    std::string error = split_to_json(malformed, 1);
+    check(error.rfind("error: ", 0) == 0);
+    check(split_to_json(malformed, test_threads) == error);
+
+    // budgets apply to the document as a whole
+    yaml::Options options;
+    options.max_nodes = 1000;
+    error = split_to_json(yaml, 1, options);
+    check(error.find("max nodes exceeded") != std::string::npos);
+    check(split_to_json(yaml, test_threads, options) == error);
+}
+
+/** Validates a string as UTF-8 on a number of threads, and returns the offset of the first invalid character (or -1). */
+static std::ptrdiff_t utf8_failure(const std::string& str, std::size_t threads)
+{
+    std::size_t pos = 0;
+    return utf8::is_valid(str.data(), str.size(), pos, threads) ? -1 : static_cast<std::ptrdiff_t>(pos);
+}
+
+// validating chunks in parallel reports the same first invalid character as a serial check
+static void test_utf8_is_valid()
+{
+    std::size_t chunk_count = std::min(4 * test_threads, (24u << 20) / utf8::min_chunk_bytes);
+    std::string str(24u << 20, 'a');
+    check(str.size() >= utf8::min_parallel_bytes);
+
+    // a 4-byte sequence straddles each chunk boundary
+    for (std::size_t k = 1; k < chunk_count; ++k) {
+        str.replace(str.size() * k / chunk_count - 2, 4, "\xF0\x9F\x98\x80");
+    }
+    check(utf8_failure(str, 1) == -1);
+    check(utf8_failure(str, test_threads) == -1);
+
+    // an invalid byte in a late chunk
+    std::size_t late = str.size() * (chunk_count - 3) / chunk_count + 12345;
+    str[late] = '\xFF';
+    check(utf8_failure(str, 1) == static_cast<std::ptrdiff_t>(late));
+    check(utf8_failure(str, test_threads) == static_cast<std::ptrdiff_t>(late));
+
+    // a run of continuation bytes longer than any valid sequence across a chunk boundary, which fails after the
+    // sequence it follows
+    std::size_t run = str.size() * 15 / chunk_count - 5;
+    str.replace(run, 6, "\xF0\x9F\x98\x80\x80\x80");
+    check(utf8_failure(str, 1) == static_cast<std::ptrdiff_t>(run + 4));
+    check(utf8_failure(str, test_threads) == static_cast<std::ptrdiff_t>(run + 4));
+
+    // a truncated sequence split across an earlier chunk boundary fails first
+    std::size_t bound = str.size() * 10 / chunk_count;
+    str.replace(bound - 2, 4, "\xF0\x9F\x98" "a");
+    check(utf8_failure(str, 1) == static_cast<std::ptrdiff_t>(bound - 2));
+    check(utf8_failure(str, test_threads) == static_cast<std::ptrdiff_t>(bound - 2));
+}
+
+/** Parses a YAML string, and writes its tree with `split::emit`, returning the JSON string, or the error message. */
+static std::string split_emit(const std::string& yaml, std::size_t threads, const json::EmitOptions& options = json::EmitOptions())
+{
+    std::string copy(yaml);
+    ryml::Tree tree;
+    check(yaml::to_tree(copy.data(), tree));
+    check(tree.size() >= split::min_parallel_nodes);
+    std::string json;
+    if (!split::emit(tree, json, options, threads)) {
+        return "error: " + yaml::error_message();
+    }
+    return json;
+}
+
+// subtrees of a large tree written in parallel join to the same bytes as the tree written as a whole
+static void test_split_emit()
+{
+    std::string data = "data:\n";
+    for (std::size_t i = 0; i < 100000; ++i) {
+        std::string n = std::to_string(i);
+        data += "- id: " + n + "\n  tags: [a, \"b\"]\n  nested: {key: '" + n + "'}\n";
+    }
+    std::string meta = "meta:\n  version: 1\n  name: \"test\"\n";
+    std::string tail = "tail: [end]\n";
+    std::string yaml = meta + data + tail;
+
+    // sibling keys before and after the large subtree
+    std::string copy(yaml);
+    std::string expected;
+    check(yaml::to_json(copy.data(), expected));
+    check(expected.rfind("{\"meta\": {", 0) == 0);
+    check(split_emit(yaml, 1) == expected);
+    check(split_emit(yaml, test_threads) == expected);
+
+    // ancestors with a single child, and keys within the container written in parallel
+    std::string wrapped = "root:\n";
+    for (std::size_t start = 0; start < yaml.size(); ) {
+        std::size_t end = yaml.find('\n', start) + 1;
+        wrapped += "  " + yaml.substr(start, end - start);
+        start = end;
+    }
+    copy = wrapped;
+    expected.clear();
+    check(yaml::to_json(copy.data(), expected));
+    check(split_emit(wrapped, test_threads) == expected);
+
+    // many keys, grouped into runs
+    std::string entries;
+    for (std::size_t i = 0; i < 80000; ++i) {
+        std::string n = std::to_string(i);
+        entries += "key" + n + ": [" + n + ", {a: b}, c]\n";
+    }
+    copy = entries;
+    expected.clear();
+    check(yaml::to_json(copy.data(), expected));
+    check(split_emit(entries, test_threads) == expected);
+
+    // the output budget applies to the tree as a whole
+    json::EmitOptions options;
+    options.max_output_bytes = expected.size() - 1;
+    std::string error = split_emit(wrapped, 1, options);
+    check(error.find("max output bytes exceeded") != std::string::npos);
+    check(split_emit(wrapped, test_threads, options) == error);
+}
+
+// columns of YAML strings convert to columns of JSON strings in the memory layout of Arrow string arrays
+static void test_transform_yaml_arrow()
+{
+    // rows 2 and 9 are null in the input, and rows 1 and 7 are malformed
+    const std::vector<std::string> rows = { "a: 1", "{a", "ignored", "[1, 2]", "- x\n- 'y'", "b: true", "\"\u00e1\"", "[1, 2", "c: null", "ignored", "d: [e]" };
+    const std::vector<const char*> expected = { "{\"a\": 1}", nullptr, nullptr, "[1,2]", "[\"x\",\"y\"]", "{\"b\": true}", "\"\u00e1\"", nullptr, "{\"c\": null}", nullptr, "{\"d\": [\"e\"]}" };
+    std::int64_t n = static_cast<std::int64_t>(rows.size());
+
+    std::vector<std::int32_t> offsets = { 0 };
+    std::string data;
+    for (const std::string& row : rows) {
+        data += row;
+        offsets.push_back(static_cast<std::int32_t>(data.size()));
+    }
+    std::vector<std::uint8_t> validity = { 0xFB, 0x05 };
+
+    std::vector<std::int32_t> out_offsets(rows.size() + 1, -1);
+    const char* out_data = nullptr;
+    std::vector<std::uint8_t> out_validity(2, 0xFF);
+    std::int64_t size = transform_yaml_arrow(offsets.data(), data.data(), n, validity.data(), out_offsets.data(), &out_data, out_validity.data());
+
+    check(out_offsets[0] == 0);
+    check(size == out_offsets[rows.size()]);
+    std::string values;
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        bool valid = (out_validity[i / 8] >> (i % 8)) & 1;
+        check(valid == (expected[i] != nullptr));
+        check(out_offsets[i] <= out_offsets[i + 1]);
+        std::string value(out_data + out_offsets[i], out_offsets[i + 1] - out_offsets[i]);
+        check(value == (expected[i] ? expected[i] : ""));
+        values += value;
+    }
+    check(out_validity[0] == 0x79 && out_validity[1] == 0x05);
+    check(std::string(out_data, static_cast<std::size_t>(size)) == values);
+
+    // all rows are valid if there is no validity bitmap
+    size = transform_yaml_arrow(offsets.data(), data.data(), 1, nullptr, out_offsets.data(), &out_data, out_validity.data());
+    check(size == 8 && out_offsets[1] == 8 && out_validity[0] == 0x01);
+    check(std::string(out_data, 8) == "{\"a\": 1}");
+}
+
+/** Reads the content of a file. */
+static std::string read_file(const std::string& path)
+{
+    std::string content;
+    if (std::FILE* file = std::fopen(path.c_str(), "rb")) {
+        char buffer[65536];
+        for (std::size_t count; (count = std::fread(buffer, 1, sizeof(buffer), file)) > 0; ) {
+            content.append(buffer, count);
+        }
+        std::fclose(file);
+    }
+    return content;
+}
+
+/** Runs the command-line converter on a file with a number of threads, and returns its output and diagnostics. */
+static std::pair<std::string, std::string> run_converter(const std::string& input, std::size_t threads)
+{
+    std::string output = input + ".jsonl";
+    std::string errors = input + ".err";
+    std::string command = "dist/yaml_to_json -j " + std::to_string(threads) + " -o " + output + " " + input + " 2> " + errors;
+    check(std::system(command.c_str()) == 0);
+    std::pair<std::string, std::string> result(read_file(output), read_file(errors));
+    std::remove(output.c_str());
+    std::remove(errors.c_str());
+    return result;
+}
+
+// the command-line converter writes one JSON line per document of a stream, regardless of the number of threads
+static void test_convert_file()
+{
+    std::string large = make_sequence(split::min_document_bytes + (1 << 20));
+    std::string stream = "# comment before the first document\n---\na: 1\n--- {b: [2\n...\n---\n- x\n- y\n...\n%YAML 1.2\n---\nd: 3\n---\n# empty\n--- |\n  literal\n---\n" + large;
+    char path[] = "/tmp/yaml_to_json_test_XXXXXX";
+    int fd = mkstemp(path);
+    check(fd >= 0);
+    check(write(fd, stream.data(), stream.size()) == static_cast<ssize_t>(stream.size()));
+    close(fd);
+
+    std::pair<std::string, std::string> serial = run_converter(path, 1);
+    std::pair<std::string, std::string> parallel = run_converter(path, test_threads);
+    std::remove(path);
+
+    std::string copy(large);
+    std::string json;
+    check(split::to_json(copy.data(), json, yaml::Options(), 1));
+    // directives before a document are skipped, and an empty document converts to null
+    check(serial.first == "{\"a\": 1}\nnull\n[\"x\",\"y\"]\n{\"d\": 3}\nnull\n\"literal\\n\"\n" + json + "\n");
+    check(parallel.first == serial.first);
+
+    // a failed document is reported with its number and the parse error
+    check(serial.second.rfind("document 2: ", 0) == 0);
+    check(serial.second.find(" in YAML at line 1 column 8 offset 7\n") != std::string::npos);
+    check(serial.second.find("7 documents (1 failed)") != std::string::npos);
+    check(parallel.second.find("7 documents (1 failed)") != std::string::npos);
+}
+
+/** Converts a YAML string to JSON with aliases and merge keys expanded, or returns the error message. */
+static std::string expand_to_json(const std::string& yaml)
+{
+    yaml::Options options;
+    options.emit.expand_aliases = true;
+    std::string copy(yaml);
+    std::string json;
+    if (!yaml::to_json(copy.data(), json, options)) {
+        return "error: " + yaml::error_message();
+    }
+    return json;
+}
+
+// maps listed earlier in a merge key take precedence, including the maps they merge from themselves
+static void test_expand_merge_keys()
+{
+    check(expand_to_json("a: &a {<<: {z: 9}, p: 1}\nb: &b {z: 2}\nc: {<<: [*a, *b]}") == "{\"a\": {\"p\": 1,\"z\": 9},\"b\": {\"z\": 2},\"c\": {\"p\": 1,\"z\": 9}}");
+    check(expand_to_json("a: &a {<<: {z: 9}, p: 1}\nb: &b {z: 2}\nc: {<<: [*b, *a]}") == "{\"a\": {\"p\": 1,\"z\": 9},\"b\": {\"z\": 2},\"c\": {\"z\": 2,\"p\": 1}}");
+    check(expand_to_json("x: &x {<<: &y {q: 1, <<: *x}, r: 2}\nc: {<<: [*x, *y], q: 0}") == "{\"x\": {\"r\": 2,\"q\": 1},\"c\": {\"q\": 0,\"r\": 2}}");
+
+    // each merged key is looked up once, such that a map with many keys merges in linear time
+    std::string base = "base: &b {";
+    for (std::size_t i = 0; i < 60000; ++i) {
+        base += (i > 0 ? ", k" : "k") + std::to_string(i) + ": " + std::to_string(i);
+    }
+    std::string json = expand_to_json(base + "}\nm: {<<: *b, k0: own}\n");
+    check(json.find("\"m\": {\"k0\": \"own\",\"k1\": 1,") != std::string::npos);
+    check(json.rfind(",\"k59999\": 59999}}") == json.size() - 18);
+}
+
+/** Converts a YAML string to a tape, or returns the error message. */
+static std::string to_tape(const std::string& yaml, const yaml::Options& options)
+{
+    std::string copy(yaml);
+    std::string tape;
+    if (!yaml::to_tape(copy.data(), tape, options)) {
+        return "error: " + yaml::error_message();
+    }
+    return tape;
+}
+
+// a tape has aliases and merge keys expanded just as JSON output does
+static void test_tape_expand_aliases()
+{
+    yaml::Options options;
+    options.emit.expand_aliases = true;
+    std::string anchored = "base: &b {x: 1, y: 2}\nderived:\n  <<: *b\n  y: 3\nlist: &l [1, \"two\"]\ncopy: *l\nscalar: &s 1\nalias: *s\n";
+    std::string expanded = "base: {x: 1, y: 2}\nderived: {y: 3, x: 1}\nlist: [1, \"two\"]\ncopy: [1, \"two\"]\nscalar: 1\nalias: 1\n";
+    check(to_tape(anchored, options) == to_tape(expanded, yaml::Options()));
+    check(to_tape(anchored, yaml::Options()) != to_tape(expanded, yaml::Options()));
+
+    // the expansion budget and missing anchors fail the same way
+    options.emit.max_expansion_bytes = 4;
+    check(to_tape(anchored, options).find("max expansion bytes exceeded") != std::string::npos);
+    options.emit.max_expansion_bytes = json::EmitOptions().max_expansion_bytes;
+    check(to_tape("x: *undefined", options).find("anchor not found") != std::string::npos);
+}
+
+int main()
+{
+    test_split_to_json();
+    test_utf8_is_valid();
+    test_split_emit();
+    test_transform_yaml_arrow();
+    test_convert_file();
+    test_expand_merge_keys();
+    test_tape_expand_aliases();
+    std::printf("all native tests passed\n");
+    return 0;
+}
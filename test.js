@@ -1,7 +1,7 @@
 const assert = require('assert');
-const { check_yaml } = require('./dist/check_yaml.js');
-const { yaml_to_json_array } = require('./dist/yaml_to_json_array.js');
-const { yaml_to_json_string } = require('./dist/yaml_to_json_string.js');
+const { check_yaml, configure: check_configure } = require('./dist/check_yaml.js');
+const { yaml_to_json_array, yaml_to_object, yaml_open, yaml_contains, schema_begin, yaml_to_columns, configure, statistics } = require('./dist/yaml_to_json_array.js');
+const { yaml_to_json_string, yaml_to_json_or_error } = require('./dist/yaml_to_json_string.js');
 const { atob } = require('./src/base64.js');
 
 function check_yaml_string(yaml) {
@@ -145,3 +145,193 @@ const j = {
 };
 assert.deepStrictEqual(JSON.parse(yaml_to_json_string(y)), j);
 assert.deepStrictEqual(JSON.parse(yaml_to_json_binary(y)), j);
+
+// repeated YAML strings served from the result cache
+configure({ cache_capacity: 1 << 20 });
+for (let k = 0; k < 3; ++k) {
+  assert.deepStrictEqual(JSON.parse(yaml_to_json_binary(y)), j);
+  assert.strictEqual(yaml_to_json_array(new TextEncoder("utf-8").encode('{}{}')), null);
+}
+assert.strictEqual(statistics().cache_misses, 2);
+assert.strictEqual(statistics().cache_hits, 4);
+configure({ cache_capacity: 0 });
+assert.strictEqual(statistics().cache_entries, 0);
+
+// control characters escaped in JSON strings
+assert.strictEqual(yaml_to_json_string(String.raw`a: "x\u0001y\tz\u001F"`), String.raw`{"a": "x\u0001y\tz\u001f"}`);
+assert.deepStrictEqual(JSON.parse(yaml_to_json_binary(String.raw`"\"quoted\" and \\ \b\f\n\r"`)), '"quoted" and \\ \b\f\n\r');
+
+// plain scalars that are not valid JSON numbers become strings
+assert.strictEqual(yaml_to_json_string('[1, -0, 1.0, 1e5, .5, +1, 01, 00.5, 1., true, null, ~]'), '[1,-0,1.0,1e5,".5","+1","01","00.5","1.",true,null,"~"]');
+
+// JSON input takes a fast path that skips building a YAML tree
+const fast_path_count = statistics().json_fast_path;
+assert.strictEqual(yaml_to_json_binary(' {"a": [1, -2.5e3, {"b": "\\u263A\\n"}], "c": null}\n'), '{"a": [1,-2.5e3,{"b": "\\u263A\\n"}],"c": null}');
+assert.strictEqual(yaml_to_json_binary('{"a": [1, 2,], "b": .5}'), '{"a": [1,2],"b": ".5"}');
+assert.strictEqual(statistics().json_fast_path, fast_path_count + 1);
+
+// tree storage is reserved up front based on a quick scan of the input
+assert.strictEqual(statistics().node_regrowths, 0);
+
+// a document larger than the initial heap, which grows Wasm memory
+const large_yaml = "- {id: 12345, name: an item in a long list, tags: [alpha, beta], price: 12.5}\n".repeat(1 << 17);
+const large_json = yaml_to_json_array(new TextEncoder("utf-8").encode(large_yaml));
+assert.strictEqual(JSON.parse(new TextDecoder("utf-8").decode(large_json)).length, 1 << 17);
+assert.deepStrictEqual(JSON.parse(yaml_to_json_binary(y)), j);
+
+// documents nested deeper than the configured limit convert to null
+const deep_yaml = "- ".repeat(100) + "leaf";
+assert.strictEqual(yaml_to_json_array(new TextEncoder("utf-8").encode(deep_yaml)), null);
+assert.strictEqual(yaml_to_json_array(new TextEncoder("utf-8").encode("[".repeat(100) + "]".repeat(100))), null);
+configure({ max_depth: 1000 });
+assert.strictEqual(yaml_to_json_binary(deep_yaml), "[".repeat(100) + '"leaf"' + "]".repeat(100));
+configure({ max_depth: 2 });
+assert.strictEqual(yaml_to_json_binary("[[1]]"), "[[1]]");
+assert.strictEqual(yaml_to_json_array(new TextEncoder("utf-8").encode("[[[1]]]")), null);
+configure({ max_depth: 64 });
+
+// documents that exceed a per-row budget convert to null, and `check_yaml` names the limit
+const encode = text => new TextEncoder("utf-8").encode(text);
+configure({ max_input_bytes: 16, max_nodes: 4, max_output_bytes: 12 });
+assert.strictEqual(yaml_to_json_binary("[1, 2]"), "[1,2]");
+assert.strictEqual(yaml_to_json_array(encode("key: a long value")), null);
+assert.strictEqual(yaml_to_json_array(encode("[1, 2, 3, 4, 5]")), null);
+assert.strictEqual(yaml_to_json_array(encode("- 1\n- 2\n- 3\n- 4\n")), null);
+assert.strictEqual(yaml_to_json_array(encode("k: [abcdefgh]")), null);
+configure({ max_input_bytes: 0, max_nodes: 0, max_output_bytes: 0 });
+assert.strictEqual(yaml_to_json_binary("[1, 2, 3, 4, 5]"), "[1,2,3,4,5]");
+check_configure({ max_nodes: 4 });
+assert.ok(check_yaml_string("- 1\n- 2\n- 3\n- 4\n").startsWith("max nodes exceeded"));
+check_configure({ max_nodes: 0, max_output_bytes: 4 });
+assert.ok(check_yaml_string("[1, 2, 3]").startsWith("max output bytes exceeded"));
+check_configure({ max_output_bytes: 0, max_input_bytes: 4 });
+assert.ok(check_yaml_string("[1, 2, 3]").startsWith("max input bytes exceeded"));
+check_configure({ max_input_bytes: 0 });
+assert.strictEqual(check_yaml_string("[1, 2, 3]"), null);
+
+// aliases and merge keys are expanded on request, within a budget
+const anchored = "base: &b {x: 1, y: 2}\nderived:\n  <<: *b\n  y: 3\nlist: &l [1, 2]\ncopy: *l\n";
+assert.deepStrictEqual(JSON.parse(yaml_to_json_binary(anchored)).copy, "*l");
+configure({ expand_aliases: true });
+assert.deepStrictEqual(JSON.parse(yaml_to_json_binary(anchored)), { base: { x: 1, y: 2 }, derived: { x: 1, y: 3 }, list: [1, 2], copy: [1, 2] });
+assert.deepStrictEqual(yaml_to_object(encode(anchored)), JSON.parse(yaml_to_json_binary(anchored)));
+assert.deepStrictEqual(JSON.parse(yaml_to_json_binary("a: &a {<<: {z: 9}, p: 1}\nb: &b {z: 2}\nc: {<<: [*a, *b]}")).c, { p: 1, z: 9 });
+let laughs = 'a: &a ["lol","lol","lol","lol","lol","lol","lol","lol","lol"]\n';
+for (let level = 1; level < 9; ++level) {
+  const name = String.fromCharCode(97 + level), prev = String.fromCharCode(96 + level);
+  laughs += `${name}: &${name} [${Array(9).fill("*" + prev).join(",")}]\n`;
+}
+assert.strictEqual(yaml_to_json_array(encode(laughs)), null);
+assert.strictEqual(yaml_to_json_array(encode("x: *undefined")), null);
+assert.strictEqual(yaml_to_object(encode(laughs)), undefined);
+configure({ expand_aliases: false });
+check_configure({ expand_aliases: true });
+assert.ok(check_yaml_string(laughs).startsWith("max expansion bytes exceeded"));
+check_configure({ expand_aliases: false });
+
+// a single call returns either JSON or the reason for failure
+assert.deepStrictEqual(yaml_to_json_or_error("a: [1, 2]"), { json: '{"a": [1,2]}', error: null });
+const failure = yaml_to_json_or_error("{a");
+assert.strictEqual(failure.json, null);
+assert.strictEqual(failure.error, check_yaml_string("{a"));
+
+// values are built directly from a tape, and agree with parsing the JSON output
+for (const doc of ["a: [1, -2.5e3, true, false, null, ~]", "- x\n- 'y'\n- \"\"\n- \"nul\\0\"", "árvíztűrő: tükörfúrógép 😀", "{a: {b: [[], {}]}}", "[]", "5", "''", "--- k: v"]) {
+  assert.deepStrictEqual(yaml_to_object(encode(doc)), JSON.parse(yaml_to_json_binary(doc)));
+}
+assert.strictEqual(yaml_to_object(encode("")), null);
+const proto = yaml_to_object(encode('{"__proto__": {"x": 1}}'));
+assert.ok(Object.prototype.hasOwnProperty.call(proto, "__proto__"));
+assert.strictEqual(Object.getPrototypeOf(proto), Object.prototype);
+assert.deepStrictEqual(proto, JSON.parse('{"__proto__": {"x": 1}}'));
+assert.strictEqual(yaml_to_object(encode("{a")), undefined);
+
+// documents are parsed once, and queried by path many times
+const opened = yaml_open(encode("a:\n  b: [1, 'x', {c: true}]\n  d.e: ~\nn: null\n"));
+assert.deepStrictEqual(opened.get("a.b"), [1, "x", { c: true }]);
+assert.strictEqual(opened.get("a.b[2].c"), true);
+assert.strictEqual(opened.get('a["d.e"]'), "~");
+assert.strictEqual(opened.get("a.x"), undefined);
+assert.strictEqual(opened.type("a"), "object");
+assert.strictEqual(opened.type("a.b[0]"), "number");
+assert.strictEqual(opened.type("n"), "null");
+assert.strictEqual(opened.type("a.b[3]"), undefined);
+assert.strictEqual(opened.length("a.b"), 3);
+assert.strictEqual(opened.length("a.b[1]"), undefined);
+assert.strictEqual(statistics().open_documents, 1);
+opened.close();
+assert.strictEqual(statistics().open_documents, 0);
+assert.strictEqual(yaml_open(encode("{a")), null);
+const handles = Array.from({ length: 17 }, () => yaml_open(encode("- x")));
+assert.strictEqual(handles[16], null);
+handles.slice(0, 16).forEach(h => h.close());
+
+// predicates stop parsing as soon as the result is known
+assert.strictEqual(yaml_contains(encode("env: prod\nitems: [1, 2]"), "env", "prod"), true);
+assert.strictEqual(yaml_contains(encode("env: 'prod'\nitems: [1, 2"), "env", "prod"), true);
+assert.strictEqual(yaml_contains(encode("env: dev\nitems: [1, 2]"), "env", "prod"), false);
+assert.strictEqual(yaml_contains(encode("a: {b: [x, {c: 8080}]}"), "a.b[1].c", "8080"), true);
+assert.strictEqual(yaml_contains(encode("a: {b: [x, {c: 8080}]}"), "a.b", "x"), false);
+assert.strictEqual(yaml_contains(encode("a: {b: [x, {c: 8080}]}"), "a.d", "x"), false);
+assert.strictEqual(yaml_contains(encode("{a"), "a", "x"), null);
+
+const column_rows = ["a: 1\nb: [x, 'y']\nc: {d: true}\n", "{a", "a: first\nc: [1]\n"].map(encode);
+assert.deepStrictEqual(yaml_to_columns(column_rows, ["a", "b[1]", "c.d", "c"]), [
+  [1, undefined, "first"], ["y", undefined, undefined], [true, undefined, undefined], [{ d: true }, undefined, [1]]
+]);
+assert.deepStrictEqual(yaml_to_columns([encode("a: again")], ["a", "b[1]", "c.d", "c"]), [["again"], [undefined], [undefined], [undefined]]);
+assert.strictEqual(yaml_to_columns([encode("a: 1")], ["a..b"]), null);
+
+const schema = schema_begin();
+assert.strictEqual(schema.add(encode("a: 1\nb: [x, 2]\n")), true);
+assert.strictEqual(schema.add(encode("a: 'longer'\nb: []\n")), true);
+assert.strictEqual(schema.add(encode("{a")), false);
+const other_schema = schema_begin();
+other_schema.add(encode("b: [{c: true}]"));
+schema.merge(other_schema);
+other_schema.delete();
+assert.deepStrictEqual(schema.result(), {
+  rows: 3, errors: 1, dropped: 0, paths: [
+    ["", "object", 3, 2], ["a", "number", 1, 1], ["a", "string", 1, 6], ["b", "array", 3, 2],
+    ["b[]", "number", 1, 1], ["b[]", "string", 1, 1], ["b[]", "object", 1, 1], ["b[].c", "boolean", 1, 4]
+  ]
+});
+schema.delete();
+
+// instances are re-created from the same compiled Wasm code, as in UDF templates
+const { acquire_instance, INSTANCE_MAX_ROWS } = require('./src/instance.js');
+const emscripten_output = require('fs').readFileSync(__dirname + '/dist/yaml_to_json_array.js', 'utf8');
+function setup(Module, WebAssembly) {
+  new Function("Module", "WebAssembly", "require", "__dirname", emscripten_output)(Module, WebAssembly, require, __dirname + '/dist');
+}
+let instance = acquire_instance(setup, undefined);
+const compiled = instance.recycler.compiled;
+assert.ok(compiled instanceof WebAssembly.Module);
+instance.recycler.rows = INSTANCE_MAX_ROWS;
+instance = acquire_instance(setup, instance);
+assert.strictEqual(instance.recycler.resets, 1);
+assert.strictEqual(instance.recycler.compiled, compiled);
+assert.strictEqual(new TextDecoder("utf-8").decode(instance.yaml_to_json_array(new TextEncoder("utf-8").encode("[1, 2]"))), "[1,2]");
+
+// the native addon (see `make addon`) is a drop-in for the Wasm build, and is tested if it has been built
+const addon_path = __dirname + '/dist/yaml_to_json.node';
+if (require('fs').existsSync(addon_path)) {
+  const addon = require(addon_path);
+  const addon_rows = [yaml, y, "[1, 2]", "{a"].map(encode);
+  const wasm_results = addon_rows.map(row => yaml_to_json_array(row));
+  addon_rows.forEach((row, i) => assert.deepStrictEqual(addon.yamlToJson(row), wasm_results[i] && Buffer.from(wasm_results[i])));
+  assert.strictEqual(addon.checkYaml(encode("a: 1")), null);
+  assert.ok(addon.checkYaml(encode("{a")) instanceof Uint8Array);
+  addon.yamlToJsonBatch(addon_rows).then(results => {
+    results.forEach((result, i) => assert.deepStrictEqual(result, wasm_results[i] && Buffer.from(wasm_results[i])));
+  });
+}
+
+// worker threads share the compiled Wasm code, and return results in input order
+const { YamlPool } = require('./src/pool.js');
+const pool = new YamlPool(2);
+const pool_rows = Array.from({ length: 100 }, (_, i) => encode(i % 10 == 0 ? "{a" : `a: ${i}\nb: [${i}]`));
+pool.convert(pool_rows).then(results => {
+  results.forEach((result, i) => assert.deepStrictEqual(result, yaml_to_json_array(pool_rows[i])));
+  return pool.close();
+}).then(() => assert.rejects(pool.convert(pool_rows), /no worker threads/));
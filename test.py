@@ -0,0 +1,42 @@
+# unit tests of the CPython extension module `yaml_to_json`; run with `make test-python`
+
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "dist"))
+
+import yaml_to_json  # noqa: E402
+
+# a simple YAML string
+assert yaml_to_json.yaml_to_json(b"{foo: 1, bar: [2, 3], john: doe}") == b'{"foo": 1,"bar": [2,3],"john": "doe"}'
+assert yaml_to_json.check_yaml(b"{foo: 1, bar: [2, 3], john: doe}") is None
+
+# an invalid YAML string
+assert yaml_to_json.yaml_to_json(b"{}{}") is None
+assert isinstance(yaml_to_json.check_yaml(b"{}{}"), str)
+
+# any bytes-like object is accepted
+assert yaml_to_json.yaml_to_json(bytearray(b"a: 1")) == b'{"a": 1}'
+assert yaml_to_json.yaml_to_json(memoryview(b"a: 1")) == b'{"a": 1}'
+try:
+    yaml_to_json.yaml_to_json("a: 1")
+    assert False, "expected TypeError"
+except TypeError:
+    pass
+
+# a batch converts in input order, with None for malformed YAML strings, regardless of the number of threads
+rows = [b"{a" if i % 7 == 0 else f"id: {i}\nitems: [{i}, '{i}']".encode() for i in range(1000)]
+expected = [yaml_to_json.yaml_to_json(row) for row in rows]
+assert expected[0] is None and expected[1] == b'{"id": 1,"items": [1,"1"]}'
+assert yaml_to_json.yaml_to_json_many(rows) == expected
+assert yaml_to_json.yaml_to_json_many(rows, threads=1) == expected
+assert yaml_to_json.yaml_to_json_many(rows, threads=4) == expected
+assert yaml_to_json.yaml_to_json_many(tuple(rows), threads=len(rows) + 1) == expected
+assert yaml_to_json.yaml_to_json_many([]) == []
+
+# a batch with an item that is not bytes-like raises an error
+try:
+    yaml_to_json.yaml_to_json_many([b"a: 1", 2])
+    assert False, "expected TypeError"
+except TypeError:
+    pass